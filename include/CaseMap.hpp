@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "Config.hpp"
+
+/**
+ * @brief Folding of nicknames and channel names under the server's
+ * casemapping: two names are the same when their folded forms are equal, so
+ * the folded form is what indexes them. The mapping is a 256 byte table per CASEMAPPING, one lookup per byte.
+ */
+class CaseMap{
+	public:
+		static std::string	fold(std::string_view name, CASEMAPPING mapping);
+		static void			fold(std::string_view name, CASEMAPPING mapping, std::string& out); // reuses out's buffer
+		static bool			equals(std::string_view a, std::string_view b, CASEMAPPING mapping);
+		static const char*	getName(CASEMAPPING mapping); // as advertised in RPL_ISUPPORT
+
+	private:
+		CaseMap() = delete;
+};
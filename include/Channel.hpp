@@ -15,6 +15,9 @@
 #include <string>
 #include <iostream>
 #include <unordered_set>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
 
 #include "Server.hpp"
 #include "Client.hpp"
@@ -26,28 +29,43 @@ enum class USERTYPE {
     INVITE
 };
 
+/**
+ * @brief A member of a channel with its channel modes, the members are packed
+ * in one array so a broadcast is a linear scan. Members are held by handle,
+ * Server::getClient() resolves them; a stale one resolves to nullptr.
+ */
+struct ChannelMember{
+    static constexpr uint8_t    OPERATOR = 1 << 0;
+
+    ClientHandle    client;
+    uint8_t     modes; // bits above, there is room for more (voice, ...)
+};
+
 class Channel{
 	public:
 		Channel() = delete;
-        Channel(const std::string& name, Client& user);
+        Channel(const std::string& name, std::string key, Client& user);
         Channel(const Channel&) = delete;
 		Channel& operator=(const Channel& other) = delete;
 		~Channel();
 
         const std::string& getName() const;
+        const std::string& getKey() const;
         const std::string& getPassword() const;
         const std::string& getTopic() const;
         bool        getInviteMode() const;
         bool        getTopicMode() const;
         bool        getPasswdMode() const;
         bool        getLimitMode() const;
+        bool        getAuditoriumMode() const;
         size_t      channelSize();
-        const std::unordered_set<Client*>&  getChannelUsers() const;
+        const std::vector<ChannelMember>&   getChannelUsers() const;
 
         // Channel's set mode:
         void        setInviteOnly();
         void        unsetInviteOnly();
         void        addNewInviteUser(Client& user);
+        void        removeInviteUser(Client& user);
 
         void        setTopicRestrictions();
         void        unsetTopicRestrictions();
@@ -61,6 +79,9 @@ class Channel{
         void        unsetLimit();
         void        addLimit(int limit);
 
+        void        setAuditorium();
+        void        unsetAuditorium();
+
         // Regular user and Channel Operator:
         void        addNewUser(Client& user);
         void        removeUser(Client& user);
@@ -74,29 +95,50 @@ class Channel{
         bool        isThereOperatorInChannel();
 
         // General:
-        void        notifyChannelUsers(Client& target, const std::string& msg);
+        void        notifyChannelUsers(Client& target, const std::string& msg,
+                        TRAFFIC traffic = TRAFFIC::ESSENTIAL);
+        void        notifyChannelUsers(Client& target, const Payload& payload,
+                        TRAFFIC traffic = TRAFFIC::ESSENTIAL);
+        void        notifyMembershipChange(Client& target, const Payload& payload);
+        bool        isHiddenMember(Client& user);
         bool        isEmptyChannel();
         bool        isFullChannel();
-        void        insertUser(std::shared_ptr<Client>user, USERTYPE type);
+        void        insertUser(Client& user, USERTYPE type);
         bool        isUserInList(Client& user, USERTYPE type);
         Client*     getTheFirstUser() const;
 
+        // NAMES:
+        const std::vector<std::string>&   getNames(bool operators_only = false);
+        size_t      namesBudget() const;
+        void        invalidateNames();
+
         // for testing only
         // void    printChannelInfo() const;
         // void    printUsers(USERTYPE type) const;
 
     private:
-        std::string channel_name_;
+        std::string channel_name_; // as the creator spelled it, used in the replies
+        const std::string channel_key_; // folded name, Server::channels_ keys are views of it
         std::string channel_passwd_;
         std::string channel_topic_;
         bool        channel_invite_only_;
         bool        channel_restric_topic_;
         bool        channel_with_passwd_;
         bool        channel_user_limit_;
+        bool        channel_auditorium_; // +u, members see the joins and leaves of the operators only
         size_t      user_limit_;
 
-        std::unordered_set<Client*> users_; // Channels don’t own users; they just refer to them.
-        std::unordered_set<Client*> operators_;
-        std::unordered_set<Client*> invited_users_;
+        // Channels don’t own users; they just refer to them.
+        std::vector<ChannelMember>  members_; // in no particular order, removal swaps the last one in
+        std::unordered_map<ClientHandle, size_t, ClientHandleHash>  member_index_; // position in members_
+        std::unordered_set<ClientHandle, ClientHandleHash>  invited_users_;
+
+        // the 353 name lists, "@op nick ...", each one fits in a line of its own
+        std::vector<std::string>    names_;
+        std::vector<std::string>    operator_names_; // what a non operator sees of a +u channel
+        bool        names_valid_;
+
+        ChannelMember*  findMember(const Client& user);
+        void        appendName(const Client& user, uint8_t modes);
 
 };
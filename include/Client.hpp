@@ -15,59 +15,186 @@
 #include <string>
 #include <iostream>
 #include <sys/socket.h> // for recv()
-#include <cstring> // for std::memset
+#include <string_view>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <vector>
 
-#define BUFFER_SIZE (5000)
+#include "SendQueue.hpp"
+#include "RecvBuffer.hpp"
+#include "TimerWheel.hpp"
+#include "TokenBucket.hpp"
+#include "StringPool.hpp"
+
+class Channel;
+
+/**
+ * @brief Names a client without pointing at it: the reactor that owns it, its
+ * socket, and the generation of its slot in that reactor's ClientTable. A
+ * handle that outlives its client resolves to nothing, even after the fd and
+ * the slot are reused.
+ */
+struct ClientHandle{
+	int			fd;
+	uint16_t	reactor;
+	uint32_t	generation; // 0 is no client
+
+	bool	operator==(const ClientHandle& other) const;
+	bool	operator!=(const ClientHandle& other) const;
+};
+
+struct ClientHandleHash{
+	size_t	operator()(const ClientHandle& handle) const;
+};
+
+/**
+ * What the client's timer is waiting for:
+ *  REGISTERING: PASS/NICK/USER to complete;
+ *  ACTIVE:      the time to check the connection with a PING (or the idle limit);
+ *  AWAIT_PONG:  anything from the client after the server's PING.
+ */
+enum class CONNSTATE {
+	REGISTERING,
+	ACTIVE,
+	AWAIT_PONG
+};
 
 class Client{
 	public:
+		// IRCv3 capabilities negotiated with CAP REQ
+		static constexpr uint8_t	CAP_MULTI_PREFIX = 1 << 0;
+		static constexpr uint8_t	CAP_NO_IMPLICIT_NAMES = 1 << 1; // JOIN doesn't send NAMES
+
 		Client();
-		Client(int fd, std::string host);
+		Client(ClientHandle handle, Interned host);
 		Client&	operator=(const Client& other);
 		~Client();
 
 		// getters
 		int					getSocketFd() const;
+		const ClientHandle&	getHandle() const;
+		int					getReactorId() const;
 		const std::string&	getNick() const;
 		const std::string&	getUsername() const;
 		const std::string&	getRealname() const;
 		const std::string&	getHostname() const;
 		const std::string&	getPassword() const;
-		bool				getNextMessage(std::string& buffer);
-		std::string			getPrefix() const;
+		bool				getNextMessage(std::string_view& line);
+		bool				hasNextMessage();
+		const std::string&	getPrefix() const;
 		const std::string&	getUserMode() const;
 		int					getUserNChannel() const;
+		const std::string&	getDisconnectReason() const;
 
 		// setters
 		void	setNick(const std::string& nick);
 		void	setUsername(const std::string& username);
 		void	setRealname(const std::string& realname);
-		void	setHostname(const std::string& hostname);
+		void	setHostname(Interned hostname);
 		void	setServername(const std::string& servername);
 		void	setPassword(const std::string& passwd);
 		void	setRegistrationStatus(bool	status);
 		void	setUserMode(const std::string& mode);
-		void	increaseUserNchannel();
 
-		bool	receiveRawData();
+		bool	receiveRawData(size_t budget);
+		void	appendRawData(const char* data, size_t len);
 		bool	isRegistered();
 
+		// outbound data
+		bool	queueResponse(const Payload& payload);
+		SendQueue&	getSendQueue();
+		bool	hasPendingOutput() const;
+		bool	isWatchingWrite() const;
+		void	setWatchingWrite(bool status);
+		bool	isWatchingRead() const;
+		void	setWatchingRead(bool status);
+		bool	isInFlushList() const;
+		void	setInFlushList(bool status);
+		bool	isInReadyList() const;
+		void	setInReadyList(bool status);
+		bool	isCorked() const;
+		void	setCorked(bool status);
+		void	markForDisconnect(const std::string& reason);
+		bool	isMarkedForDisconnect() const;
+		bool	isLagged() const;
+		void	setLagged(bool status);
+		void	countDropped();
+		size_t	takeDropped();
+
+		// liveness, the timer belongs to the owner reactor's wheel
+		TimerWheel::Timer&	getTimer();
+		CONNSTATE	getConnState() const;
+		void		setConnState(CONNSTATE state);
+		void		touch(std::chrono::steady_clock::time_point now, bool is_command);
+		std::chrono::steady_clock::time_point	getLastActivity() const;
+		std::chrono::steady_clock::time_point	getLastCommand() const;
+		std::chrono::steady_clock::time_point	getPingSent() const;
+		void		setPingSent(std::chrono::steady_clock::time_point when);
+
+		// memberships, kept by Channel as users join, leave and get invited
+		const std::vector<Channel*>&	getChannels() const;
+		const std::vector<Channel*>&	getInvites() const;
+		void	addChannel(Channel* channel);
+		void	removeChannel(Channel* channel);
+		void	addInvite(Channel* channel);
+		void	removeInvite(Channel* channel);
+		bool	visit(uint64_t epoch); // false when visited in this epoch already
+
+		// flood control
+		TokenBucket&		getFloodBucket();
+		TimerWheel::Timer&	getFloodTimer();
+		bool		isThrottled() const;
+		void		setThrottled(bool status);
+		uint64_t	getFloodPoints() const;
+		void		addFloodPoints(uint64_t points);
+
+		// capabilities
+		bool		hasCap(uint8_t cap) const;
+		uint8_t		getCaps() const;
+		void		setCaps(uint8_t caps);
+
 		// for testing
 		// void	printInfo() const;
 		// void    printRawData() const;
 
 	private:
-		int	socket_fd_;
+		ClientHandle	handle_; // socket and owner reactor (event loop thread)
 		std::string	nick_;
 		std::string	username_;
 		std::string	realname_;
-		std::string	hostname_;
+		Interned	hostname_; // shared with the other clients from the same host
+		std::string	prefix_; // ":nick!~user@host", rebuilt by the setters of its parts
 		std::string	servername_;
 		std::string password_;
-		std::string	raw_data_;
+		RecvBuffer	recv_buffer_;
 		std::string	user_mode_;
 		bool		isRegistered_;
-		int			n_usr_channel_;
+		std::vector<Channel*>	channels_; // joined channels, a handful: a vector beats a set
+		std::vector<Channel*>	invites_; // channels it was invited to but hasn't joined
+		uint64_t				fanout_mark_; // epoch of the last fanout that reached it
+		SendQueue	send_queue_;
+		bool		watching_write_; // waiting for the socket to be writable
+		bool		watching_read_; // false while throttled
+		bool		in_flush_list_; // queued replies are written at the end of the tick
+		bool		in_ready_list_; // has lines left over after its budget ran out
+		bool		corked_; // TCP_CORK is set on the socket
+		bool		marked_for_disconnect_;
+		bool		lagged_; // send queue passed the high watermark, not under the low one yet
+		size_t		n_dropped_; // DROPPABLE payloads skipped while lagged
+		std::string	disconnect_reason_;
+		TimerWheel::Timer	timer_;
+		CONNSTATE			conn_state_;
+		std::chrono::steady_clock::time_point	last_activity_; // any line
+		std::chrono::steady_clock::time_point	last_command_; // any line but PING/PONG
+		std::chrono::steady_clock::time_point	ping_sent_; // the server's last PING
+		TokenBucket			flood_bucket_;
+		TimerWheel::Timer	flood_timer_; // armed while throttled, until the bucket has tokens again
+		bool				throttled_; // out of tokens, lines wait in the receive buffer
+		uint64_t			flood_points_; // the cost of the commands that went over the limit
+		uint8_t				caps_; // CAP_* bits
+
+		void	updatePrefix();
 
 		Client(const Client&) = delete;
 };
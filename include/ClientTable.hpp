@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <optional>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "Client.hpp"
+
+/**
+ * @brief The clients of one reactor, in slots indexed by their fd.
+ *
+ * fds are small dense integers, so a slot is found with two array indexes
+ * instead of a hash lookup. The slots come in chunks of 64, allocated the
+ * first time one of their fds is accepted and kept for reuse afterwards. The
+ * chunk directory is sized once for the process' fd limit and never moves.
+ *
+ * Only the owner reactor adds and removes clients, and it holds state_mutex_
+ * while it does. The other reactors read the table under the same mutex, the
+ * owner reads it at any time.
+ *
+ * Every add() bumps the slot's generation, which is how a ClientHandle tells
+ * the slot's current client apart from an earlier one. A removed client isn't
+ * destroyed right away, the caller may still be running one of its commands:
+ * it lives until collect() at the end of the tick, or until its slot is reused.
+ */
+class ClientTable{
+	public:
+		explicit ClientTable(int reactor_id);
+
+		Client&		add(int fd, Interned host);
+		void		remove(Client& cli);
+		Client*		get(int fd) const; // the live client on fd, if any
+		Client*		get(const ClientHandle& handle) const; // nullptr once it is gone
+		size_t		size() const;
+		void		collect();
+		template<typename F>
+		void		forEach(F&& f) const;
+
+	private:
+		static constexpr int	CHUNK_BITS = 6;
+		static constexpr int	CHUNK_SIZE = 1 << CHUNK_BITS;
+
+		struct Slot{
+			uint32_t				generation = 0;
+			bool					live = false;
+			std::optional<Client>	client;
+		};
+
+		int										reactor_id_;
+		std::vector<std::unique_ptr<Slot[]>>	chunks_;
+		std::vector<int>						removed_; // fds of the clients collect() destroys
+		size_t									n_clients_;
+
+		Slot*	findSlot(int fd) const;
+
+		ClientTable(const ClientTable&) = delete;
+		ClientTable& operator=(const ClientTable&) = delete;
+};
+
+template<typename F>
+void	ClientTable::forEach(F&& f) const{
+	for (const auto& chunk : chunks_){
+		if (!chunk){
+			continue;
+		}
+		for (int i = 0; i < CHUNK_SIZE; i++){
+			if (chunk[i].live){
+				f(*chunk[i].client);
+			}
+		}
+	}
+}
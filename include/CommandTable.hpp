@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string_view>
+#include <cstdint>
+
+enum COMMANDTYPE{
+	PASS,
+	NICK,
+	USER,
+	PRIVMSG,
+	JOIN,
+	PART,
+	KICK,
+	INVITE,
+	TOPIC,
+	MODE,
+	QUIT,
+	CAP,
+	PING,
+	PONG,
+	WHOIS,
+	WHO,
+	NAMES,
+	INVALID
+};
+
+/**
+ * @brief What the server knows about a command, next to its name.
+ */
+struct CommandInfo{
+	static constexpr uint8_t	BEFORE_PASS = 1 << 0; // allowed before the right password was given
+	static constexpr uint8_t	BEFORE_REGISTRATION = 1 << 1; // allowed before the client is registered
+
+	std::string_view	name;
+	COMMANDTYPE			type;
+	uint8_t				flags;
+	int					cost; // flood control tokens, --flood-cost can override it
+};
+
+/**
+ * @brief The commands of the server, the one place they are spelled out.
+ *
+ * A name is classified by a perfect hash built at compile time: a couple of
+ * its bytes and its length give the only slot it can be in, one comparison
+ * tells whether it is there. Names are case sensitive.
+ */
+class CommandTable{
+	public:
+		static COMMANDTYPE			lookup(std::string_view name); // INVALID if it isn't a command
+		static const CommandInfo&	get(COMMANDTYPE type); // INVALID has no flags and costs 1
+
+	private:
+		CommandTable() = delete;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <utility>
+
+#include "Logger.hpp"
+
+#define DEFAULT_FLUSH_DELAY_US (200)
+#define MAX_WORKERS (64)
+// Work a client gets per event loop iteration before the next client is served
+#define DEFAULT_TICK_BYTES (16 * 1024)
+#define DEFAULT_TICK_COMMANDS (64)
+// Connection timeouts in seconds
+#define DEFAULT_REGISTER_TIMEOUT (30)
+#define DEFAULT_PING_INTERVAL (120)
+#define DEFAULT_PING_TIMEOUT (60)
+// Send queue watermarks in bytes, the hard limit is SENDQ_LIMIT
+#define DEFAULT_SENDQ_HIGH (512 * 1024)
+#define DEFAULT_SENDQ_LOW (128 * 1024)
+// Flood control: tokens a client earns per second and can save up
+#define DEFAULT_FLOOD_RATE (20)
+#define DEFAULT_FLOOD_BURST (100)
+
+/**
+ * When the replies queued for a client are written to its socket:
+ *  IMMEDIATE:   on every reply, lowest latency, one syscall per reply;
+ *  END_OF_TICK: once per event loop iteration, all the replies produced for
+ *               the client in that iteration go out in one writev();
+ *  CORK:        like END_OF_TICK, but the socket is kept TCP_CORKed for up to
+ *               flush_delay_us so replies of several iterations share packets.
+ */
+enum class FLUSHPOLICY {
+	IMMEDIATE,
+	END_OF_TICK,
+	CORK
+};
+
+/**
+ * What happens to a client whose send queue passes the high watermark:
+ *  DISCONNECT: it is dropped with "SendQ exceeded";
+ *  DROP:       it is marked lagged and misses the channel messages (the
+ *              essential traffic, like JOIN/PART/KICK/replies, is still queued)
+ *              until the queue is back under the low watermark;
+ *  LAG:        it is marked lagged and its own commands aren't read until then,
+ *              so it stops producing replies.
+ * Past SENDQ_LIMIT the client is disconnected whatever the policy.
+ */
+enum class SENDQPOLICY {
+	DISCONNECT,
+	DROP,
+	LAG
+};
+
+/**
+ * Which characters are the same letter in nick and channel names (advertised as CASEMAPPING
+ * in RPL_ISUPPORT):
+ *  RFC1459: A-Z are a-z, and []\~ are the lower case {}|^ (Scandinavian origin);
+ *  ASCII:   only A-Z are a-z.
+ */
+enum class CASEMAPPING {
+	RFC1459,
+	ASCII
+};
+
+/**
+ * How a reactor waits for I/O:
+ *  EPOLL:    readiness notifications, the server calls recv()/writev() itself;
+ *  IO_URING: the kernel accepts, receives and sends on the server's behalf and
+ *            reports completions, one syscall per event loop iteration.
+ */
+enum class BACKENDTYPE {
+	EPOLL,
+	IO_URING
+};
+
+/**
+ * @brief Tunables of the server, the defaults can be changed with the optional
+ * command line options after <port> <password>.
+ */
+struct ServerConfig{
+	FLUSHPOLICY	flush_policy;
+	int			flush_delay_us;
+	int			workers; // number of reactor threads
+	BACKENDTYPE	backend;
+	int			tick_bytes; // bytes read and parsed per client per tick
+	int			tick_commands; // commands executed per client per tick
+	int			register_timeout; // seconds to complete PASS/NICK/USER
+	int			ping_interval; // seconds of silence before the server sends a PING
+	int			ping_timeout; // seconds to answer it
+	int			idle_timeout; // seconds without a command, 0 = never
+	size_t		sendq_high; // bytes queued before the sendq policy applies
+	size_t		sendq_low; // a lagged client is back to normal under this
+	SENDQPOLICY	sendq_policy;
+	int			flood_rate; // tokens per second, 0 = no flood control
+	int			flood_burst;
+	std::vector<std::pair<std::string, int>>	flood_costs; // command name and cost, overriding the defaults
+	CASEMAPPING	casemapping;
+	LOGPOLICY	log_overflow; // when the log ring is full
+
+	ServerConfig();
+
+	static ServerConfig	fromArgs(int ac, char** av);
+	static std::string	usage();
+};
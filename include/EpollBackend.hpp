@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <sys/epoll.h>
+
+#include "EventBackend.hpp"
+
+/**
+ * @brief Readiness based backend: level-triggered epoll for the clients (EPOLLOUT
+ * only while output is pending), edge-triggered for the listening socket.
+ */
+class EpollBackend : public EventBackend{
+	public:
+		EpollBackend();
+		~EpollBackend();
+
+		const char*	getName() const override;
+		void		addListener(int fd) override;
+		void		addWakeUpFd(int fd) override;
+		void		addClient(int fd) override;
+		void		removeClient(int fd) override;
+		ssize_t		send(int fd, SendQueue& queue) override;
+		void		watch(int fd, bool read, bool write) override;
+		int			wait(int timeout_ms, IoHandler& handler) override;
+
+	private:
+		static constexpr int	MAX_EVENTS = 1024;
+
+		int								epoll_fd_;
+		int								listen_fd_;
+		int								wake_fd_;
+		std::vector<struct epoll_event>	events_;
+
+		void	acceptAll(IoHandler& handler);
+
+		EpollBackend(const EpollBackend&) = delete;
+		EpollBackend& operator=(const EpollBackend&) = delete;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <sys/types.h> // for ssize_t
+
+#include "Config.hpp"
+
+class SendQueue;
+
+/**
+ * @brief What a reactor does with the I/O events. The backends differ in what
+ * they report: epoll tells that a socket is readable and the handler recv()s
+ * itself (onReadable), io_uring hands over bytes the kernel already received
+ * (onData).
+ */
+class IoHandler{
+	public:
+		virtual ~IoHandler(){}
+
+		virtual void	onAccept(int fd) = 0; // a new, non-blocking client socket
+		virtual void	onReadable(int fd) = 0;
+		virtual void	onData(int fd, const char* data, size_t len) = 0;
+		virtual void	onWritable(int fd) = 0; // queued output can make progress again
+		virtual void	onClose(int fd) = 0; // hang-up or socket error
+		virtual void	onWakeUp() = 0; // the reactor's eventfd was written
+};
+
+/**
+ * @brief The I/O multiplexing part of a reactor. One instance per reactor, only
+ * used by the reactor's thread.
+ *
+ * A client socket is registered with addClient() and must be unregistered with
+ * removeClient() before it is closed; afterwards no event for it is reported,
+ * even when the fd number is reused by a new client in the same batch.
+ */
+class EventBackend{
+	public:
+		virtual ~EventBackend(){}
+
+		static std::unique_ptr<EventBackend>	create(BACKENDTYPE type);
+
+		virtual const char*	getName() const = 0;
+		virtual void		addListener(int fd) = 0;
+		virtual void		addWakeUpFd(int fd) = 0;
+		virtual void		addClient(int fd) = 0;
+		virtual void		removeClient(int fd) = 0;
+		// Start sending queued data, returns the bytes taken from the queue or -1
+		// on a socket error. Whatever is left is retried on onWritable().
+		virtual ssize_t		send(int fd, SendQueue& queue) = 0;
+		// Which events the client wants: read = false stops receiving (the data
+		// stays in the socket), write = true while output is queued.
+		virtual void		watch(int fd, bool read, bool write) = 0;
+		// Wait up to timeout_ms (-1: no limit) and dispatch the events to handler.
+		virtual int			wait(int timeout_ms, IoHandler& handler) = 0;
+};
@@ -13,9 +13,13 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <chrono>
 #include <ctime>
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <cstdint>
 
 // Define colours
 #define RESET "\033[0;0m"
@@ -28,6 +32,31 @@
  #define LOG_LEVEL Logger::INFO
 #endif // LOG_LEVEL
 
+// Records the ring holds (a power of two), past that the overflow policy applies
+#define LOG_RING_SIZE (8192)
+// Bytes of a message a record keeps, a longer one is cut
+#define LOG_RECORD_TEXT (240)
+// How long the writer sleeps when the ring is empty
+#define LOG_WRITER_SLEEP_MS (5)
+
+/**
+ * What log() does when the ring is full:
+ *  DROP:  the line is counted and thrown away, the writer reports how many;
+ *  BLOCK: it waits for the writer to make room. Nothing is lost, but a slow
+ *         terminal can stall the event loops.
+ */
+enum class LOGPOLICY {
+	DROP,
+	BLOCK
+};
+
+/**
+ * @brief The server's log. log() copies the message into a fixed-size record
+ * of a bounded lock-free ring (any thread can write to it, none takes a lock)
+ * and returns; a writer thread formats the records and writes them out in
+ * batches, one flush per batch. Before start() and after stop() log() writes
+ * the line itself.
+ */
 class Logger{
 	public:
 		enum LEVEL{
@@ -39,12 +68,36 @@ class Logger{
 		static const std::chrono::system_clock::time_point start_time;
 
 		~Logger();
-		static void log(enum LEVEL level, std::string msg);
+		static void log(enum LEVEL level, std::string_view msg);
+		static bool isEnabled(enum LEVEL level);
+		static void start(LOGPOLICY policy);
+		static void stop(); // writes out what is left, once the other threads are done logging
 
 	private:
+		struct Record{
+			std::atomic<size_t>	seq; // which lap of the ring the record belongs to, see push()
+			long long			ms; // since start_time
+			LEVEL				level;
+			bool				cut; // the message was longer than LOG_RECORD_TEXT
+			uint16_t			len;
+			char				text[LOG_RECORD_TEXT];
+		};
+
+		static Record				ring_[LOG_RING_SIZE];
+		alignas(64) static std::atomic<size_t>	enqueue_pos_;
+		alignas(64) static size_t	dequeue_pos_; // the writer's
+		static std::atomic<uint64_t>	dropped_;
+		static std::atomic<bool>	running_;
+		static LOGPOLICY			policy_;
+		static std::thread			writer_;
+
 		Logger() = delete;
 		Logger(const Logger&) = delete;
 		Logger& operator=(const Logger&) = delete;
 
-		static void cleanMessage(std::string& msg);
+		static bool push(enum LEVEL level, long long ms, std::string_view msg);
+		static void writerLoop();
+		static size_t drain(std::string& batch);
+		static void format(std::string& out, enum LEVEL level, long long ms, std::string_view msg);
+		static void cleanMessage(std::string_view& msg);
 };
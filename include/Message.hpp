@@ -13,28 +13,58 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <iostream>
-#include <unordered_set>
-#include <vector>
+#include <array>
 #include "Server.hpp"
 
+// The most tokens one list of a message holds, the rest of a longer line is ignored
+#define MSG_MAX_PARAMS (64)
+
 class Client;
 
+/**
+ * @brief Fixed-capacity list of tokens of a message. The tokens are views into
+ * the line, which lives in the client's receive buffer: nothing is copied and
+ * nothing is allocated, whatever the command.
+ */
+class ParamList{
+	public:
+		ParamList();
+
+		bool				push_back(std::string_view token); // false when full
+		size_t				size() const;
+		bool				empty() const;
+		std::string_view	operator[](size_t index) const;
+		std::string_view	at(size_t index) const; // throws std::out_of_range like std::vector
+		const std::string_view*	begin() const;
+		const std::string_view*	end() const;
+
+	private:
+		std::array<std::string_view, MSG_MAX_PARAMS>	slots_;
+		size_t											size_;
+};
+
+/**
+ * @brief One line of a client, split into its command, parameters and trailing
+ * part. Everything it hands out points into the line: a Message must not
+ * outlive the line it was built from.
+ */
 class Message{
 	public:
-		Message(std::string& message);
+		explicit Message(std::string_view message);
 		~Message();
 
 		bool					parseMessage();
-		const std::string& 		getWholeMessage() const;
+		std::string_view 		getWholeMessage() const;
 		int 					getNumberOfParameters() const;
-		const std::string&		getTrailing() const;
-		const std::vector<std::string>&	getParameters() const;
-		const std::vector<std::string>&	getUsers() const;
-		const std::vector<std::string>&	getChannels() const;
+		std::string_view		getTrailing() const;
+		const ParamList&		getParameters() const;
+		const ParamList&		getUsers() const;
+		const ParamList&		getChannels() const;
 		COMMANDTYPE 			getCommandType() const;
-		const std::string& 		getCommandString() const;
-		const std::vector<std::string>& getPasswords() const;
+		std::string_view 		getCommandString() const;
+		const ParamList&		getPasswords() const;
 		bool getTrailingEmpty() const;
 
 		// for testing only
@@ -42,9 +72,6 @@ class Message{
 		// void	printUserList() const;
 
 	private:
-		using CommandHandler = std::function<bool()>;
-		std::unordered_map<std::string, CommandHandler> command_handlers_;
-		void				initCommandHandlers();
 		bool				handleGeneric();
 		bool				handleCAP();
 		bool 				handlePASS();
@@ -52,16 +79,16 @@ class Message{
 		bool				handleJOIN();
 		bool				handleMODE();
 		bool				handleNoParse();
-		bool 				validateParameters(const std::string& command);
-		std::string			whole_msg_;
+		bool 				validateParameters();
+		std::string_view	whole_msg_; // the line in the client's receive buffer
 		int					number_of_parameters_;
-		std::string			msg_trailing_;//everything found after :
-		std::vector<std::string>	parameters_;//All the parameters, except commandtype or trailing message
-		std::vector<std::string>	msg_users_;//parameters that should be users in the message
-		std::vector<std::string>	msg_channels_;//parameters that should be channels in the message
+		std::string_view	msg_trailing_;//everything found after :
+		ParamList			parameters_;//All the parameters, except commandtype or trailing message
+		ParamList			msg_users_;//parameters that should be users in the message
+		ParamList			msg_channels_;//parameters that should be channels in the message
 		COMMANDTYPE			cmd_type_;//type of the command as defined in the server.hpp
-		std::string			cmd_string_;//string version of the given command
-		std::vector<std::string>	passwords_;//passwords for the JOIN command if it exists
+		std::string_view	cmd_string_;//string version of the given command
+		ParamList			passwords_;//passwords for the JOIN command if it exists
 		bool				msg_trailing_empty_;//set to true only if the msg_trailing_ was ":"
 };
 
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+
+#include "EventBackend.hpp"
+#include "SendQueue.hpp"
+#include "TimerWheel.hpp"
+#include "ClientTable.hpp"
+
+/**
+ * @brief Bytes for a client owned by another reactor. The sender can't touch
+ * that client's send queue, so the data travels through the owner's inbox. The
+ * payload is shared, a broadcast isn't copied per remote recipient.
+ * The handle tells a delivery for a closed client apart from a new client that
+ * got the same fd.
+ */
+struct Delivery{
+	ClientHandle	client;
+	Payload			data;
+	TRAFFIC			traffic;
+};
+
+/**
+ * @brief One event loop: a listening socket (SO_REUSEPORT, every reactor binds
+ * the same port and the kernel spreads the connections), an event backend
+ * (epoll or io_uring) and the clients accepted on it. With --workers N the server runs N reactors, each
+ * on its own thread. Only the owner thread touches the reactor's clients' sockets
+ * and send queues; other threads post() to its inbox and wake it up through an
+ * eventfd.
+ */
+class Reactor{
+	public:
+		Reactor(int id, BACKENDTYPE backend);
+		~Reactor();
+
+		int		getId() const;
+		void	post(Delivery&& delivery);
+		std::vector<Delivery>&	takeInbox();
+		void	wakeUp();
+		void	clearWakeUp();
+
+	private:
+		friend class Server;
+
+		int								id_;
+		int								serv_fd_;
+		int								wake_fd_; // eventfd, readable when the inbox has data
+		std::unique_ptr<EventBackend>	backend_;
+		ClientTable													clients_; // clients accepted by this reactor, by socket
+		std::vector<int>											pending_disconnects_; // clients to remove after the event batch
+		std::vector<int>											flush_list_; // clients with replies queued in this tick
+		std::deque<int>												ready_list_; // clients with unprocessed lines, served round robin
+		std::vector<std::pair<int, std::chrono::steady_clock::time_point>>	corked_clients_; // fd and uncork deadline
+		TimerWheel												timers_; // registration, ping and idle timeouts of the clients
+		TimerWheel												flood_timers_; // when throttled clients have tokens again
+
+		std::mutex				inbox_mutex_;
+		std::vector<Delivery>	inbox_;
+		std::vector<Delivery>	drained_; // owner only, what takeInbox() handed out
+
+		Reactor() = delete;
+		Reactor(const Reactor&) = delete;
+		Reactor& operator=(const Reactor&) = delete;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// Free space guaranteed before every recv()
+#define RECVBUF_CHUNK (4096)
+// An empty buffer larger than this gives its memory back (after a big burst)
+#define RECVBUF_KEEP (32 * 1024)
+
+/**
+ * @brief Inbound bytes of a client, framed into lines ending with LF (CRLF, or
+ * a bare LF as many clients send).
+ *
+ * The bytes live in one contiguous block: data is written at the end, lines
+ * are taken from the front as string_views into the block, no copy and no
+ * allocation per line. The consumed front is reclaimed by moving the (short)
+ * unconsumed tail down when room is needed for the next write, so a large
+ * pipelined burst costs linear time.
+ *
+ * Newly received bytes are scanned once, 16 or 32 at a time (SSE2 or AVX2,
+ * whichever the CPU has, memchr() elsewhere): the end of every line in them
+ * is queued, and nextLine() just pops the queue. A line arriving in many
+ * small pieces isn't rescanned from its start.
+ *
+ * A line handed out by nextLine() stays valid until the next write.
+ */
+class RecvBuffer{
+	public:
+		RecvBuffer();
+		~RecvBuffer();
+
+		char*	prepareWrite(size_t min_room);
+		size_t	writable() const;
+		void	commitWrite(size_t n);
+		void	append(const char* data, size_t len);
+		bool	nextLine(std::string_view& line);
+		bool	hasLine();
+		size_t	size() const;
+
+	private:
+		std::vector<char>	data_;
+		size_t				start_; // first unconsumed byte
+		size_t				end_; // end of the received bytes
+		size_t				scan_; // the bytes before it are scanned
+		std::vector<size_t>	line_ends_; // position after the LF of every complete line
+		size_t				next_line_; // first entry of line_ends_ not handed out
+
+		bool	scan();
+};
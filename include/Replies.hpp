@@ -13,11 +13,68 @@
 #pragma once
 
 #include <iostream>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <charconv>
+
+#include "SendQueue.hpp"
 
 #define SERVER "irc.ircserv.com"
 #define SUPPORTUSERMODE "o"
-#define SUPPORTCHANNELMODE "itkol"
+#define SUPPORTCHANNELMODE "itkolu"
+#define SUPPORTCAPS "multi-prefix draft/no-implicit-names"
 #define CRLF "\r\n" // Carriage Return - Line Feed
+#define IRC_LINE_MAX (512) // bytes in a line, CRLF included
+// The start of a numeric reply, ":irc.ircserv.com 001 ", a literal put together
+// by the compiler
+#define NUMERIC(code) ":" SERVER " " code " "
+
+/**
+ * @brief The reply builder: the parts of a reply (string_views, chars and
+ * numbers) are measured, then written one after the other into the payload
+ * that goes to the send queues, and the line is ended with CRLF. One allocation
+ * of the right size per reply, no temporary string. The constant parts are
+ * string literals, so ":" SERVER " 001 " costs nothing at run time.
+ *
+ * Pass numbers as uint64_t, a plain int would be ambiguous between char and
+ * uint64_t.
+ */
+inline size_t	replyPartSize(std::string_view part){
+	return part.size();
+}
+
+inline size_t	replyPartSize(char){
+	return 1;
+}
+
+inline size_t	replyPartSize(uint64_t){
+	return 20; // the digits of UINT64_MAX
+}
+
+inline void	appendReplyPart(std::string& out, std::string_view part){
+	out.append(part);
+}
+
+inline void	appendReplyPart(std::string& out, char c){
+	out.push_back(c);
+}
+
+inline void	appendReplyPart(std::string& out, uint64_t number){
+	char	digits[20];
+	auto	result = std::to_chars(digits, digits + sizeof(digits), number);
+	out.append(digits, result.ptr - digits);
+}
+
+template<typename... Parts>
+inline Payload	buildReply(const Parts&... parts){
+	std::shared_ptr<std::string>	data = std::make_shared<std::string>();
+	data->reserve((replyPartSize(parts) + ... + 2));
+	(appendReplyPart(*data, parts), ...);
+	data->append(CRLF);
+	return data;
+}
 
 /**
  * What is "inline" for?
@@ -31,93 +88,106 @@
 /*...................................General Replies..............................*/
 
 // NOTICE
-inline std::string noticeToUser(const std::string& nick,
-								const std::string& message) {
-    return ":" + std::string(SERVER) + " NOTICE " + nick + " :" + message + CRLF;
+inline Payload noticeToUser(std::string_view nick,
+							std::string_view message) {
+    return buildReply(":" SERVER " NOTICE ", nick, " :", message);
 }
 
 /*...................................Commands Replies..............................*/
 
 // 001 RPL_WELCOME
-inline std::string rplWelcome(const std::string& nick,
-							  const std::string& prefix){
-	return ":" + std::string(SERVER) + " 001 " + nick + " :Welcome to the Internet Relay Network " + prefix + CRLF;
+inline Payload rplWelcome(std::string_view nick,
+						  std::string_view prefix){
+	return buildReply(NUMERIC("001"), nick, " :Welcome to the Internet Relay Network ", prefix);
 }
 
 // 002 RPL_YOURHOST
-inline std::string rplYourHost(const std::string& nick){
-	return ":" + std::string(SERVER) + " 002 " + nick + " :Your host is " + std::string(SERVER) + ", running version ircserv 1.0" + CRLF;
+inline Payload rplYourHost(std::string_view nick){
+	return buildReply(NUMERIC("002"), nick, " :Your host is " SERVER ", running version ircserv 1.0");
 }
 
 // 003 RPL_CREATED
-inline std::string rplCreated(const std::string& nick){
-	return ":" + std::string(SERVER) + " 003 " + nick + " :This server was created on May 10 2025" + CRLF;
+inline Payload rplCreated(std::string_view nick){
+	return buildReply(NUMERIC("003"), nick, " :This server was created on May 10 2025");
 }
 
 // 004 RPL_MYINFO
-inline std::string rplMyInfo(const std::string& nick){
-	return ":" + std::string(SERVER) + " 004 " + nick + " :" + std::string(SERVER) + " 1.0 " + std::string(SUPPORTUSERMODE) + " " + std::string(SUPPORTCHANNELMODE) + CRLF;
+inline Payload rplMyInfo(std::string_view nick){
+	return buildReply(NUMERIC("004"), nick, " :" SERVER " 1.0 " SUPPORTUSERMODE " " SUPPORTCHANNELMODE);
+}
+
+// 005 RPL_ISUPPORT
+inline Payload rplISupport(std::string_view nick,
+						   std::string_view casemapping){
+	return buildReply(NUMERIC("005"), nick, " CASEMAPPING=", casemapping, " PREFIX=(o)@ CHANMODES=,k,l,itu :are supported by this server");
 }
 
 // 221 RPL_UMODEIS
-inline std::string rplUserModeIs(const std::string& nick,
-								 const std::string& modes){
-    return ":" + std::string(SERVER) + " 221 " + nick + " " + modes + CRLF;
+inline Payload rplUserModeIs(std::string_view nick,
+							 std::string_view modes){
+    return buildReply(NUMERIC("221"), nick, " ", modes);
 }
 
 // 318 RPL_ENDOFWHOIS
-inline std::string rplEndOfWhois(const std::string& nick,
-								 const std::string& targetNick){
-	return ":" + std::string(SERVER) + " 318 " + nick + " " + targetNick + " :End of /WHOIS list" + CRLF;
+inline Payload rplEndOfWhois(std::string_view nick,
+							 std::string_view targetNick){
+	return buildReply(NUMERIC("318"), nick, " ", targetNick, " :End of /WHOIS list");
 }
 
 // 311 RPL_WHOISUSER
-inline std::string rplWhoisUser(const std::string& nick,
-								const std::string& targetNick,
-								const std::string& user,
-								const std::string& host,
-								const std::string& realName){
-	return ":" + std::string(SERVER) + " 311 " + nick + " " + targetNick + " " + user + " " + host + " * :" + realName + CRLF;
+inline Payload rplWhoisUser(std::string_view nick,
+							std::string_view targetNick,
+							std::string_view user,
+							std::string_view host,
+							std::string_view realName){
+	return buildReply(NUMERIC("311"), nick, " ", targetNick, " ", user, " ", host, " * :", realName);
 }
 
 // 312 RPL_WHOISSERVER
-inline std::string rplWhoIsServer(const std::string& requestorNick,
-								  const std::string& targetNick){
-	return ":" + std::string(SERVER) + " 312 " + requestorNick + " " + targetNick + std::string(SERVER) + " :Your IRC Server :)" + CRLF;
+inline Payload rplWhoIsServer(std::string_view requestorNick,
+							  std::string_view targetNick){
+	return buildReply(NUMERIC("312"), requestorNick, " ", targetNick, SERVER " :Your IRC Server :)");
 }
 
 // 315 RPL_ENDOFWHO
-inline std::string rplEndOfWho(const std::string& nick,
-							   const std::string& target) {
-	return ":" + std::string(SERVER) + " 315 " + nick + " " + target + " :End of /WHO list." + CRLF;
+inline Payload rplEndOfWho(std::string_view nick,
+						   std::string_view target) {
+	return buildReply(NUMERIC("315"), nick, " ", target, " :End of /WHO list.");
 }
 
 
+// 320 RPL_WHOISSPECIAL
+inline Payload rplWhoIsFloodPoints(std::string_view nick,
+								   std::string_view targetNick,
+								   uint64_t points){
+	return buildReply(NUMERIC("320"), nick, " ", targetNick, " :has ", points, " flood points");
+}
+
 // 319 RPL_WHOISCHANNELS
-inline std::string rplWhoIsChannels(const std::string& nick,
-									const std::string& targetNick,
-									const std::string& channels){
-	return ":" + std::string(SERVER) + " 319 " + nick + " " + targetNick + " :" + channels + CRLF;
+inline Payload rplWhoIsChannels(std::string_view nick,
+								std::string_view targetNick,
+								std::string_view channels){
+	return buildReply(NUMERIC("319"), nick, " ", targetNick, " :", channels);
 }
 
 // 324 RPL_CHANNELMODEIS
-inline std::string ChannelModeIs(const std::string& nick,
-								 const std::string& channel,
-								 const std::string& mode){
-	return ":" + std::string(SERVER) + " 324 " + nick + " " + channel + " " + mode + CRLF;
+inline Payload ChannelModeIs(std::string_view nick,
+							 std::string_view channel,
+							 std::string_view mode){
+	return buildReply(NUMERIC("324"), nick, " ", channel, " ", mode);
 }
 
 // 331 RPL_NOTOPIC
-inline std::string NoTopic(const std::string& nick, 
-					       const std::string& channel){
-	return ":" + std::string(SERVER) + " 331 " + nick + " " + channel + " :No topic is set" + CRLF;
+inline Payload NoTopic(std::string_view nick, 
+				       std::string_view channel){
+	return buildReply(NUMERIC("331"), nick, " ", channel, " :No topic is set");
 }
 
 // 332 RPL_TOPIC
-inline std::string Topic(const std::string& nick,
-						 const std::string& channel,
-						 const std::string& topic){
-	return ":" + std::string(SERVER) + " 332 " + nick + " " + channel + " :" + topic + CRLF;
+inline Payload Topic(std::string_view nick,
+					 std::string_view channel,
+					 std::string_view topic){
+	return buildReply(NUMERIC("332"), nick, " ", channel, " :", topic);
 }
 
 // 341 RPL_INVITING
@@ -125,21 +195,21 @@ inline std::string Topic(const std::string& nick,
  * @brief Returned by the server to indicate that the attempted INVITE message was
  * successful and is being passed onto the end client.
  */
-inline std::string Inviting(const std::string& nick, 
-							const std::string& channel,
-							const std::string& target){
-	return ":" + std::string(SERVER) + " 341 " + nick + " " + target + " " + channel + CRLF;
+inline Payload Inviting(std::string_view nick, 
+						std::string_view channel,
+						std::string_view target){
+	return buildReply(NUMERIC("341"), nick, " ", target, " ", channel);
 }
 
 // 352 RPL_WHOREPLY
-inline std::string rplWhoReply(const std::string& requester,
-							   const std::string& channel,
-							   const std::string& user,
-							   const std::string& host,
-							   const std::string& nick,
-							   const std::string& status,
-							   const std::string& realname){
-	return ":" + std::string(SERVER) + " 352 " + requester + " " + channel + " " + user + " " + host + " " + std::string(SERVER) + " " + nick + " " + status + " :0 " + " " + realname + CRLF;
+inline Payload rplWhoReply(std::string_view requester,
+						   std::string_view channel,
+						   std::string_view user,
+						   std::string_view host,
+						   std::string_view nick,
+						   std::string_view status,
+						   std::string_view realname){
+	return buildReply(NUMERIC("352"), requester, " ", channel, " ", user, " ", host, " " SERVER " ", nick, " ", status, " :0 " " ", realname);
 }
 
 /**
@@ -148,15 +218,14 @@ inline std::string rplWhoReply(const std::string& requester,
  * This message is sent to all users in the channel (except the target) and directly to the kicked user.
  * It follows the IRC format: ":<kicker> KICK <channel> <target> [:reason]"
  */
-inline std::string rplKick(const std::string& nick,
-						   const std::string& target,
-						   const std::string& channel, 
-						   const std::string& reason){
-	std::string msg = ":" + nick + " KICK " + channel + " " + target;
+inline Payload rplKick(std::string_view nick,
+					   std::string_view target,
+					   std::string_view channel, 
+					   std::string_view reason){
 	if (!reason.empty()) {
-		msg += " :" + reason;
+		return buildReply(":", nick, " KICK ", channel, " ", target, " :", reason);
 	}
-	return msg + CRLF;
+	return buildReply(":", nick, " KICK ", channel, " ", target);
 }
 
 // RPL_MODE
@@ -166,20 +235,20 @@ inline std::string rplKick(const std::string& nick,
  * This message is sent to all users in the channel to inform them of a mode change.
  * It follows the IRC format: ":<nick> MODE <channel> <modes> [<args>...]"
  */
-inline std::string rplMode(const std::string& prefix, 
-						   const std::string& channelName,
-	                       const std::string& modes, 
-						   const std::string& params){
-	return prefix + " MODE " + channelName + " " + modes + " " + params + CRLF;
+inline Payload rplMode(std::string_view prefix, 
+					   std::string_view channelName,
+                       std::string_view modes, 
+					   std::string_view params){
+	return buildReply(prefix, " MODE ", channelName, " ", modes, " ", params);
 }
 
 // RPL_JOINCHANNEL
 /**
  * @brief Broadcast JOIN message
  */
-inline std::string rplJoin(const std::string& prefix, 
-						   const std::string& channel){
-	return prefix + " JOIN " + channel + CRLF;
+inline Payload rplJoin(std::string_view prefix, 
+					   std::string_view channel){
+	return buildReply(prefix, " JOIN ", channel);
 }
 
 // RPL_PART
@@ -189,10 +258,10 @@ inline std::string rplJoin(const std::string& prefix,
  * This message is sent to all users in the channel, including the parting user.
  * It follows the IRC format: ":<nick> PART <channel> [:reason]"
  */
-inline std::string rplPart(const std::string& prefix, 
-						   const std::string& channel,
-						   const std::string& partMessage){
-	return prefix + " PART " + channel + " :" + partMessage + CRLF;
+inline Payload rplPart(std::string_view prefix, 
+					   std::string_view channel,
+					   std::string_view partMessage){
+	return buildReply(prefix, " PART ", channel, " :", partMessage);
 }
 
 // RPL_QUIT
@@ -202,15 +271,15 @@ inline std::string rplPart(const std::string& prefix,
  * This message is sent to all users in the channel, including the parting user.
  * It follows the IRC format: ":<nick> PART <channel> [:reason]"
  */
-inline std::string rplQuit(const std::string& prefix, 
-						   const std::string& message)
+inline Payload rplQuit(std::string_view prefix, 
+					   std::string_view message)
 {
-	return prefix + " QUIT :" + message + CRLF;
+	return buildReply(prefix, " QUIT :", message);
 }
 
-inline std::string rplResetNick(const std::string& prefix, 
-								const std::string& newNick){
-	return prefix + " NICK :" + newNick + CRLF;
+inline Payload rplResetNick(std::string_view prefix, 
+							std::string_view newNick){
+	return buildReply(prefix, " NICK :", newNick);
 }
 
 // RPL_PRIVMSG
@@ -221,10 +290,10 @@ inline std::string rplResetNick(const std::string& prefix,
  * @param target: message receiveer, can be a user or a channel
  * @param message: message that sender input
  */
-inline std::string rplPrivMsg(const std::string& source, 
-							  const std::string& target,
-							  const std::string& message){
-	return ":" + source + " PRIVMSG " + target + " :" + message + CRLF;
+inline Payload rplPrivMsg(std::string_view source, 
+						  std::string_view target,
+						  std::string_view message){
+	return buildReply(":", source, " PRIVMSG ", target, " :", message);
 }
 
 /*...................................Error Replies.................................*/
@@ -237,28 +306,28 @@ inline std::string rplPrivMsg(const std::string& source,
  * @param cmd:  the command that triggered the error (e.g., JOIN, MODE)
  * @param err_msg: a human-readable error message
  */
-inline std::string unknowError(const std::string& nick, 
-							   const std::string& cmd,
-							   const std::string& err_msg){
-	return ":" + std::string(SERVER) + " 400 " + nick + " " + cmd + " :" + err_msg + CRLF;
+inline Payload unknowError(std::string_view nick, 
+						   std::string_view cmd,
+						   std::string_view err_msg){
+	return buildReply(NUMERIC("400"), nick, " ", cmd, " :", err_msg);
 }
 
 // 401 ERR_NOSUCHNICK
 /**
  * @brief Used to indicate the nickname parameter supplied to a command is currently unused.
  */
-inline std::string errNoSuchNick(const std::string& nick,
-								 const std::string& wrong_nick){
-	return ":" + std::string(SERVER) + " 401 " + nick + " " + wrong_nick + " :No such nick" + CRLF;
+inline Payload errNoSuchNick(std::string_view nick,
+							 std::string_view wrong_nick){
+	return buildReply(NUMERIC("401"), nick, " ", wrong_nick, " :No such nick");
 }
 
 // 403 ERR_NOSUCHCHANNEL
 /**
  * @brief Used to indicate the given channel name is invalid
  */
-inline std::string errNoSuchChannel(const std::string& nick,
-									const std::string& wrong_channel){
-	return ":" + std::string(SERVER) + " 403 " + nick + " " + wrong_channel+" :No such channel" + CRLF;
+inline Payload errNoSuchChannel(std::string_view nick,
+								std::string_view wrong_channel){
+	return buildReply(NUMERIC("403"), nick, " ", wrong_channel, " :No such channel");
 }
 
 // 404 ERR_CANNOTSENDTOCHAN
@@ -267,9 +336,9 @@ inline std::string errNoSuchChannel(const std::string& nick,
  * not a chanop (or mode +v) on a channel which has mode +m set and is trying to send
  * a PRIVMSG message to that channel.
  */
-inline std::string canNotSendToChan(const std::string& nick, 
-									const std::string& channel_name){
-	return ":" + std::string(SERVER) + " 404 " + nick + " " + channel_name + " :Cannot send to channel" + CRLF;
+inline Payload canNotSendToChan(std::string_view nick, 
+								std::string_view channel_name){
+	return buildReply(NUMERIC("404"), nick, " ", channel_name, " :Cannot send to channel");
 }
 
 // 405 ERR_TOOMANYCHANNELS
@@ -277,9 +346,9 @@ inline std::string canNotSendToChan(const std::string& nick,
  * @brief Sent to a user when they have joined the maximum number of allowed channels
  * and they try to join another channel.
  */
-inline std::string tooManyChannels(const std::string& nick, 
-								   const std::string& channel){
-	return ":" + std::string(SERVER) + " 405 " + nick + " " + channel + " :You have joined too many channels" + CRLF;
+inline Payload tooManyChannels(std::string_view nick, 
+							   std::string_view channel){
+	return buildReply(NUMERIC("405"), nick, " ", channel, " :You have joined too many channels");
 }
 
 // 407 ERR_TOOMANYTARGETS
@@ -287,13 +356,13 @@ inline std::string tooManyChannels(const std::string& nick,
  * @brief Sent when a command is given with too many targets (e.g., multiple channels or users),
  *        but only one is allowed (like in MODE or PRIVMSG).
  */
-inline std::string tooManyTargets(const std::string& nick) {
-	return ":" + std::string(SERVER) + " 407 " + nick + " :Too many targets" + CRLF;
+inline Payload tooManyTargets(std::string_view nick) {
+	return buildReply(NUMERIC("407"), nick, " :Too many targets");
 }
 
 // 409 ERR_NOORIGIN
-inline std::string noOrigin(const std::string& nick){
-	return ":" + std::string(SERVER) + " 409 " + nick + " :No origin specified" + CRLF;
+inline Payload noOrigin(std::string_view nick){
+	return buildReply(NUMERIC("409"), nick, " :No origin specified");
 }
 
 // 421 ERR_UNKNOWNCOMMAND
@@ -301,17 +370,17 @@ inline std::string noOrigin(const std::string& nick){
  * @brief Returned to a registered client to indicate that the command sent is unknown
  * by the server.
  */
-inline std::string unknowCommand(const std::string& nick, 
-								 const std::string& wrong_command){
-	return ":" + std::string(SERVER) + " 421 " + nick + " " + wrong_command + " :Unknown command" + CRLF;
+inline Payload unknowCommand(std::string_view nick, 
+							 std::string_view wrong_command){
+	return buildReply(NUMERIC("421"), nick, " ", wrong_command, " :Unknown command");
 }
 
 // 431 ERR_NONICKNAMEGIVEN
 /**
  * @brief Returned when a nickname parameter expected for a command and isn't found.
  */
-inline std::string nonNickNameGiven(const std::string& nick){
-	return ":" + std::string(SERVER) + " 431 " + nick + " :No nickname given" + CRLF;
+inline Payload nonNickNameGiven(std::string_view nick){
+	return buildReply(NUMERIC("431"), nick, " :No nickname given");
 }
 
 // 432 ERR_ERRONEUSNICKNAME
@@ -319,8 +388,8 @@ inline std::string nonNickNameGiven(const std::string& nick){
  * @brief Returned after receiving a NICK message which contains characters which do
  * not fall in the defined set.
  */
-inline std::string erroneusNickName(const std::string& nick){
-	return ":" + std::string(SERVER) + " 432 " + nick + " :Erroneus nickname/username" + CRLF;
+inline Payload erroneusNickName(std::string_view nick){
+	return buildReply(NUMERIC("432"), nick, " :Erroneus nickname/username");
 }
 
 // 433 ERR_NICKNAMEINUSE
@@ -328,9 +397,9 @@ inline std::string erroneusNickName(const std::string& nick){
  * @brief Returned when a NICK message is processed that results in an attempt to change
  * to a currently existing nickname.
  */
-inline std::string nickNameInUse(const std::string& nick,
-								 const std::string& new_nick){
-	return ":" + std::string(SERVER) + " 433 " + nick + " " + new_nick +" :Nickname is already in use" + CRLF;
+inline Payload nickNameInUse(std::string_view nick,
+							 std::string_view new_nick){
+	return buildReply(NUMERIC("433"), nick, " ", new_nick, " :Nickname is already in use");
 }
 
 
@@ -339,10 +408,10 @@ inline std::string nickNameInUse(const std::string& nick,
  * @brief Returned by the server to indicate that the target user of the command is
  * not on the given channel.
  */
-inline std::string userNotInChannel(const std::string& nick, 
-									const std::string& targets,
-									const std::string& channel){
-	return ":" + std::string(SERVER) + " 441 " + nick  + " "  + targets + " "+ channel + " :They aren't on that channel" + CRLF;
+inline Payload userNotInChannel(std::string_view nick, 
+								std::string_view targets,
+								std::string_view channel){
+	return buildReply(NUMERIC("441"), nick, " ", targets, " ", channel, " :They aren't on that channel");
 }
 
 // 442 ERR_NOTONCHANNEL
@@ -350,9 +419,9 @@ inline std::string userNotInChannel(const std::string& nick,
  * @brief Returned by the server whenever a client tries to perform a channel effecting
  * command for which the client isn't a member.
  */
-inline std::string notOnChannel(const std::string& nick, 
-								const std::string& channel){
-	return ":" + std::string(SERVER) + " 442 " + nick  + " " + channel + " :You're not on that channel" + CRLF;
+inline Payload notOnChannel(std::string_view nick, 
+							std::string_view channel){
+	return buildReply(NUMERIC("442"), nick, " ", channel, " :You're not on that channel");
 }
 
 // 443 ERR_USERONCHANNEL
@@ -363,12 +432,12 @@ inline std::string notOnChannel(const std::string& nick,
  * @param target: the user who is added into a channel
  * @param channel: the channel which adds a new user in
  */
-inline std::string userOnChannel(const std::string& nick,
-								 const std::string& target,
-								 const std::string& channel){
+inline Payload userOnChannel(std::string_view nick,
+							 std::string_view target,
+							 std::string_view channel){
 	if (target != "")
-		return ":" + std::string(SERVER) + " 443 " + nick  + " " + target + " " + channel + " :is already on channel" + CRLF;
-	return ":" + std::string(SERVER) + " 443 " + nick  + " " + channel + " :is already on channel" + CRLF;
+		return buildReply(NUMERIC("443"), nick, " ", target, " ", channel, " :is already on channel");
+	return buildReply(NUMERIC("443"), nick, " ", channel, " :is already on channel");
 }
 
 // 451 ERR_NOTREGISTERED
@@ -376,25 +445,30 @@ inline std::string userOnChannel(const std::string& nick,
  * @brief Returned by the server to indicate that the client must be registered before
  * the server will allow it to be parsed in detail.
  */
-inline std::string NotRegistered(const std::string& command){
-	return ":" + std::string(SERVER) + " 451 " + command  + " :You have not registered" + CRLF;
+inline Payload NotRegistered(std::string_view command){
+	return buildReply(NUMERIC("451"), command, " :You have not registered");
+}
+
+// CAP LS / ACK / NAK, the nick is always "*"
+inline Payload	rplCap(std::string_view subcommand, std::string_view caps){
+	return buildReply("CAP * ", subcommand, " :", caps);
 }
 
 // 353 RPL_NAMREPLY
-inline std::string	rplNamReply(const std::string &nick,
-							 	const std::string &channel,
-								const std::string &namesList){
-	return ":" + std::string(SERVER) + " 353 " + nick + " = " + channel + " :" + namesList + CRLF;
+inline Payload	rplNamReply(std::string_view nick,
+						 	std::string_view channel,
+							std::string_view namesList){
+	return buildReply(NUMERIC("353"), nick, " = ", channel, " :", namesList);
 }
 
 // 366 RPL_ENDOFNAMES
-inline std::string	rplEndOfNames(const std::string &nick,
-								  const std::string &channel){
-	return ":" + std::string(SERVER) + " 366 " + nick + " " + channel + " :End of /NAMES list." + CRLF;
+inline Payload	rplEndOfNames(std::string_view nick,
+							  std::string_view channel){
+	return buildReply(NUMERIC("366"), nick, " ", channel, " :End of /NAMES list.");
 }
 // 368 RPL_ENDOFBANLIST
-inline std::string rplEndOfBanList(const std::string& nick, const std::string& channel){
-    return ":" + std::string(SERVER) + " 368 " + nick + " " + channel + " :End of channel ban list" + CRLF;
+inline Payload rplEndOfBanList(std::string_view nick, std::string_view channel){
+    return buildReply(NUMERIC("368"), nick, " ", channel, " :End of channel ban list");
 }
 
 // 461 ERR_NEEDMOREPARAMS
@@ -402,8 +476,8 @@ inline std::string rplEndOfBanList(const std::string& nick, const std::string& c
  * @brief Returned by the server by numerous commands to indicate to the client that
  * it didn't supply enough parameters.
  */
-inline std::string needMoreParams(const std::string& command){
-	return ":" + std::string(SERVER) + " 461 " + command  + " :Not enough parameters" + CRLF;
+inline Payload needMoreParams(std::string_view command){
+	return buildReply(NUMERIC("461"), command, " :Not enough parameters");
 }
 
 // 462 ERR_ALREADYREGISTRED
@@ -411,8 +485,8 @@ inline std::string needMoreParams(const std::string& command){
  * @brief Returned by the server to any link which tries to change part of the
  * registered details (such as password or user details from second USER message).
  */
-inline std::string alreadyRegistred(const std::string& nick){
-	return ":" + std::string(SERVER) + " 462 " + nick  + " :You may not reregister" + CRLF;
+inline Payload alreadyRegistred(std::string_view nick){
+	return buildReply(NUMERIC("462"), nick, " :You may not reregister");
 }
 
 // 464 ERR_PASSWDMISMATCH
@@ -420,39 +494,39 @@ inline std::string alreadyRegistred(const std::string& nick){
  * @brief Returned to indicate a failed attempt at registering a connection for
  * which a password was required and was either not given or incorrect.
  */
-inline std::string passwdMismatch(const std::string& nick){
-	return ":" + std::string(SERVER) + " 464 " + nick  + " :Password incorrect" + CRLF;
+inline Payload passwdMismatch(std::string_view nick){
+	return buildReply(NUMERIC("464"), nick, " :Password incorrect");
 }
 
 // 467 ERR_KEYSET
-inline std::string keySet(const std::string& nick,
-						  const std::string& channel){
-	return ":" + std::string(SERVER) + " 467 " + nick + " " + channel + " :Channel key already set" + CRLF;
+inline Payload keySet(std::string_view nick,
+					  std::string_view channel){
+	return buildReply(NUMERIC("467"), nick, " ", channel, " :Channel key already set");
 }
 
 // 471 ERR_CHANNELISFULL
-inline std::string channelIsFull(const std::string& nick,
-								 const std::string& channel){
-	return ":" + std::string(SERVER) + " 471 " + nick + " " + channel + " :Cannot join channel (+l)" + CRLF;
+inline Payload channelIsFull(std::string_view nick,
+							 std::string_view channel){
+	return buildReply(NUMERIC("471"), nick, " ", channel, " :Cannot join channel (+l)");
 }
 
 // 472 ERR_UNKNOWNMODE
-inline std::string unknownMode(const std::string& nick,
-							   const std::string& unknown_mode,
-							   const std::string& channel){
-	return ":" + std::string(SERVER) + " 472 " + nick + " " + unknown_mode + " :is unknown mode char to me for " + channel + CRLF;
+inline Payload unknownMode(std::string_view nick,
+						   std::string_view unknown_mode,
+						   std::string_view channel){
+	return buildReply(NUMERIC("472"), nick, " ", unknown_mode, " :is unknown mode char to me for ", channel);
 }
 
 // 473 ERR_INVITEONLYCHAN
-inline std::string inviteOnlyChan(const std::string& nick,
-								  const std::string& channel){
-	return ":" + std::string(SERVER) + " 473 " + nick + " " + channel + " :Cannot join channel (+i)" + CRLF;
+inline Payload inviteOnlyChan(std::string_view nick,
+							  std::string_view channel){
+	return buildReply(NUMERIC("473"), nick, " ", channel, " :Cannot join channel (+i)");
 }
 
 // 475 ERR_BADCHANNELKEY
-inline std::string badChannelKey(const std::string& nick,
-								 const std::string& channel){
-	return ":" + std::string(SERVER) + " 475 " + nick + " " + channel + " :Cannot join channel (+k)" + CRLF;
+inline Payload badChannelKey(std::string_view nick,
+							 std::string_view channel){
+	return buildReply(NUMERIC("475"), nick, " ", channel, " :Cannot join channel (+k)");
 }
 
 // 478 ERR_INVITE_SYNTAX
@@ -460,14 +534,14 @@ inline std::string badChannelKey(const std::string& nick,
  * @brief Any command requiring 'chanop' privileges (such as MODE messages) must return this
  * error if the client making the attempt is not a chanop on the specified channel
  */
-inline std::string InviteSyntaxErr(const std::string& nick){
-	return ":" + std::string(SERVER) + " 478 " + nick + ":Invalid Invite command" + CRLF;
+inline Payload InviteSyntaxErr(std::string_view nick){
+	return buildReply(NUMERIC("478"), nick, ":Invalid Invite command");
 }
 
 // 479 ERR_BADCHANNELNAME
-inline std::string badChannelName(const std::string& nick,
-								  const std::string& channel){
-	return ":" + std::string(SERVER) + " 479 " + nick + " " + channel + " :Illegal channel name" + CRLF;
+inline Payload badChannelName(std::string_view nick,
+							  std::string_view channel){
+	return buildReply(NUMERIC("479"), nick, " ", channel, " :Illegal channel name");
 }
 
 // 482 ERR_CHANOPRIVSNEEDED
@@ -475,19 +549,19 @@ inline std::string badChannelName(const std::string& nick,
  * @brief Any command requiring 'chanop' privileges (such as MODE messages) must return this
  * error if the client making the attempt is not a chanop on the specified channel
  */
-inline std::string ChanoPrivsNeeded(const std::string& nick,
-									const std::string& channel){
-	return ":" + std::string(SERVER) + " 482 " + nick + " " + channel + " :You're not channel operator" + CRLF;
+inline Payload ChanoPrivsNeeded(std::string_view nick,
+								std::string_view channel){
+	return buildReply(NUMERIC("482"), nick, " ", channel, " :You're not channel operator");
 }
 
 // 501 ERR_UMODEUNKNOWNFLAG
-inline std::string umodeUnknownFlag(const std::string& nick){
-    return ":" + std::string(SERVER) + " 501 " + nick + " :Unknown MODE flag" + CRLF;
+inline Payload umodeUnknownFlag(std::string_view nick){
+    return buildReply(NUMERIC("501"), nick, " :Unknown MODE flag");
 }
 
 // 502 ERR_USERSDONTMATCH
-inline std::string usersDontMatch(const std::string& nick){
-    return ":" + std::string(SERVER) + " 502 " + nick + " :Cannot change mode for other users" + CRLF;
+inline Payload usersDontMatch(std::string_view nick){
+    return buildReply(NUMERIC("502"), nick, " :Cannot change mode for other users");
 }
 
 // 696 ERR_INVALIDMODEPARAM
@@ -496,10 +570,10 @@ inline std::string usersDontMatch(const std::string& nick){
  * Commonly used for +k (key), +l (limit), etc.
  * 696 is a non-standard but widely adopted IRC numeric 
  */
-inline std::string InvalidModeParamErr(const std::string& nick, 
-									   const std::string& channel,
-									   char mode, 
-									   const std::string& param, 
-									   const std::string& reason){
-    return ":" + std::string(SERVER) + " 696 " + nick + " " + channel + " " + mode + " " + param + " :" + reason + CRLF;
+inline Payload InvalidModeParamErr(std::string_view nick, 
+								   std::string_view channel,
+								   char mode, 
+								   std::string_view param, 
+								   std::string_view reason){
+    return buildReply(NUMERIC("696"), nick, " ", channel, " ", mode, " ", param, " :", reason);
 }
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <memory>
+#include <sys/types.h> // for ssize_t
+#include <sys/uio.h> // for struct iovec
+
+// Upper bound of unsent bytes a client may have buffered on the server side.
+#define SENDQ_LIMIT (1024 * 1024)
+// Max chunks handed to one writev() call
+#define SENDQ_IOV_BATCH (64)
+
+/**
+ * Immutable reply bytes. A broadcast is serialized once and the same payload is
+ * pushed to every recipient's queue, each queue only keeps a reference (and its
+ * own offset), so a message to N members is one allocation instead of N copies.
+ */
+using Payload = std::shared_ptr<const std::string>;
+
+inline Payload	makePayload(std::string data){
+	return std::make_shared<const std::string>(std::move(data));
+}
+
+/**
+ * Whether a payload may be skipped for a client that can't keep up
+ * (SENDQPOLICY::DROP): channel chatter is DROPPABLE, anything that changes what
+ * the client knows about its channels or answers its own commands is ESSENTIAL.
+ */
+enum class TRAFFIC {
+	ESSENTIAL,
+	DROPPABLE
+};
+
+/**
+ * @brief Outbound byte queue owned by every client.
+ *
+ * Replies are appended as whole payloads; flush() gathers them into one writev()
+ * so all the replies queued during an event loop iteration leave in a single
+ * syscall. Whatever the socket doesn't accept (including a partially sent front
+ * chunk) is kept for the next EPOLLOUT. The queue is bounded, push() refuses
+ * data past the limit so the caller can decide what to do with a client that
+ * doesn't read.
+ * Backends that send asynchronously (io_uring) use gather()/consume() instead
+ * of flush().
+ */
+class SendQueue{
+	public:
+		SendQueue();
+		explicit SendQueue(size_t limit);
+		~SendQueue();
+
+		bool	push(const std::string& data);
+		bool	push(const Payload& payload);
+		ssize_t	flush(int fd);
+		int		gather(struct iovec* iov, int max_iov, size_t& n_bytes, Payload* refs = nullptr) const;
+		void	consume(size_t n);
+		bool	empty() const;
+		size_t	size() const;
+		void	clear();
+
+	private:
+		std::deque<Payload>	chunks_;
+		size_t				front_offset_; // bytes of chunks_.front() already sent
+		size_t				n_bytes_; // unsent bytes over all chunks
+		size_t				limit_;
+};
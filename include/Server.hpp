@@ -19,12 +19,24 @@
 #include <vector>
 #include <stdexcept>
 #include <netinet/in.h> // for struct sockaddr_in
-#include <sys/epoll.h>
 #include <signal.h>
 #include <cstring> //for memset
 #include <fcntl.h>  // for fcntl()
 #include <set> // for std::set
+#include <array>
 #include <arpa/inet.h> // for inet_ntop
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <string_view>
+
+#include "Config.hpp"
+#include "Reactor.hpp"
+#include "CaseMap.hpp"
+#include "StringPool.hpp"
+#include "CommandTable.hpp"
 
 class Client;
 class Channel;
@@ -39,63 +51,56 @@ class Message;
 #define	SERVER_CHANNEL_LIMIT (50)
 #define USER_CHANNEL_LIMIT (20)
 #define SERVER_USER_LIMIT (5000)
+#define NICK_MAX_LEN (20)
 
-enum COMMANDTYPE{
-	PASS,
-	NICK,
-	USER,
-	PRIVMSG,
-	JOIN,
-	PART,
-	KICK,
-	INVITE,
-	TOPIC,
-	MODE,
-	QUIT,
-	CAP,
-	PING,
-	WHOIS,
-	WHO,
-	INVALID
-};
-
-class Server{
+class Server : private IoHandler{
 	public:
-		Server(std::string port, std::string password);
+		Server(std::string port, std::string password, const ServerConfig& config);
 		~Server();
 
 		void	startServer();
-		static int	responseToClient(Client& cli, const std::string& response);
+		static int	responseToClient(Client& cli, std::string response);
+		static int	responseToClient(Client& cli, const Payload& payload,
+						TRAFFIC traffic = TRAFFIC::ESSENTIAL);
+		static Client*	getClient(const ClientHandle& handle);
 
 	private:
 		int					serv_port_;
 		std::string			serv_passwd_;
 		static Server*		server_;
-		int					serv_fd_;
-		int					epoll_fd_;
 		struct sockaddr_in	serv_addr_;
 		int					n_channel_;
 		int					n_user_;
+		uint64_t			fanout_epoch_; // stamp of the last notifyNeighbors(), see Client::visit()
+		ServerConfig		config_;
 
-		static constexpr int			MAX_EVENTS = 1024;
-		static volatile sig_atomic_t	keep_running_; // internal flag
+		static std::atomic<bool>		keep_running_; // internal flag
+		static thread_local Reactor*	reactor_; // the reactor run by the calling thread
+
+		// One reactor per worker thread. The IRC state below (clients, channels,
+		// counters) is shared by all of them and guarded by state_mutex_; a
+		// reactor holds it while it runs commands or adds/removes clients.
+		std::vector<std::unique_ptr<Reactor>>	reactors_;
+		std::mutex								state_mutex_;
 
 		// std::shared_ptr<T> is a smart pointer introduced in C++11 that manages the
 		// lifetime of a dynamically allocated object. It does so using reference
 		// counting — multiple shared_ptr instances can share ownership of the same object.
 		// When the last shared_ptr pointing to that object is destroyed or reset,
 		// the object is automatically deleted.
-		std::unordered_map<int, std::shared_ptr<Client>>			clients_; // the key is client socket (client_fd)
-		std::unordered_map<std::string, std::shared_ptr<Channel>>	channels_; // string is the channel name
-		std::vector<struct epoll_event>								events_; // using for saving the clients' fds
-		static const std::set<COMMANDTYPE>							pre_registration_allowed_commands_;
-		static const std::set<COMMANDTYPE>							operator_commands_;
+		// The clients themselves live in the reactors' ClientTables.
+		std::unordered_map<std::string, Client*>					nicks_; // registered clients, the key is the nick folded under config_.casemapping
+		// the key is the folded channel name, a view of the Channel's own copy (Channel::getKey())
+		std::unordered_map<std::string_view, std::shared_ptr<Channel>>	channels_;
+		mutable std::string											fold_buffer_; // scratch of the channel lookups
+		StringPool													hosts_; // hostnames of the clients, one copy per host
+		std::vector<int>											command_costs_; // flood control tokens, indexed by COMMANDTYPE
 
 		// this defines executeFunc is a pointer to a function inside the Message class
 		// that takes two reference arguments and returns void.
 		// Using in the server class
 		using executeFunc = void (Server::*)(Message& msg, Client& cli);
-		static const std::unordered_map<COMMANDTYPE, Server::executeFunc> execute_map_;
+		static const std::array<executeFunc, INVALID>	execute_table_; // indexed by COMMANDTYPE
 
 
 		Server() = delete;
@@ -104,17 +109,48 @@ class Server{
 
 		void		setupSignalHandlers();
 		static void	signalHandler(int signum);
-		void		setupServSocket();
-		void		acceptNewClient();
-		void		processDataFromClient(int idx);
+		void		setupServSocket(Reactor& reactor);
+		void		runReactor(Reactor& reactor);
+		void		stopReactors();
+		void		drainInbox();
+		void		processMessages(Client& client);
+		void		scheduleReady(Client& cli);
+		void		throttleClient(Client& cli);
+		void		onFloodTimer(int fd);
+		void		serveReadyClients(size_t n);
 		void		removeClient(Client& usr, std::string reason);
-		void		removeChannel(const std::string& channel_name);
+		void		notifyNeighbors(Client& cli, const Payload& payload);
+		void		sendNames(Client& cli, Channel& channel);
+		std::shared_ptr<Channel>	addChannel(const std::string& channel_name, Client& creator);
+		void		removeChannel(Channel& channel);
+		int			queueToClient(Client& cli, const Payload& payload, TRAFFIC traffic);
+		void		onSendqHigh(Client& cli);
+		void		onSendqLow(Client& cli);
+		bool		isInputPaused(const Client& cli) const;
+		void		flushClient(Client& cli);
+		void		scheduleFlush(Client& cli);
+		void		flushPendingClients();
+		void		uncorkExpiredClients();
+		int			computeWaitTimeout() const;
+		void		armClientTimer(Client& cli);
+		void		onClientTimer(int fd);
+		void		updateClientEvents(Client& cli);
+		void		scheduleDisconnect(Client& cli, const std::string& reason);
+		void		disconnectMarkedClients();
 		void		executeCommand(Message& msg, Client& cli);
 		void		cleanServer();
 
+		// events of the calling thread's reactor (IoHandler)
+		void		onAccept(int fd) override;
+		void		onReadable(int fd) override;
+		void		onData(int fd, const char* data, size_t len) override;
+		void		onWritable(int fd) override;
+		void		onClose(int fd) override;
+		void		onWakeUp() override;
+
 		std::string 				getChannelsOfUser(Client& client);
-		std::shared_ptr<Channel>		getChannelByName(const std::string& channel_name) const;
-		std::shared_ptr<Client>			getUserByNick(const std::string& user_nick) const;
+		std::shared_ptr<Channel>		getChannelByName(std::string_view channel_name) const;
+		Client*							getUserByNick(std::string_view user_nick) const;
 		// Client* getClientByNick(const std::string& nick) const;
 
 		// commands
@@ -127,8 +163,10 @@ class Server{
 		void		quitCommand(Message& msg, Client& cli);
 		void		capCommand(Message& msg, Client& cli);
 		void		pingCommand(Message& msg, Client& cli);
+		void		pongCommand(Message& msg, Client& cli);
 		void		whoisCommand(Message& msg, Client& cli);
 		void		whoCommand(Message& msg, Client& cli);
+		void		namesCommand(Message& msg, Client& cli);
 		// Commands specific to channel operators:
 		void		kickUser(Message& msg, Client& cli);
 		void		inviteUser(Message& msg, Client& cli);
@@ -139,10 +177,12 @@ class Server{
 		bool		isPasswordMatch(const std::string& password);
 		void		attempRegisterClient(Client& cli);
 		bool		isNickInUse(const std::string& nick, const Client* requesting_client);
-		bool		isExistedChannel(const std::string& channel_name);
+		std::string	foldNick(std::string_view nick) const;
+		bool		isExistedChannel(std::string_view channel_name) const;
 		bool		isValidModePassword(const std::string& password);
 		bool 		isPositiveInteger(const std::string& s);
-		bool		isChannelValid(const std::string& channel_name);
+		bool		isChannelValid(std::string_view channel_name);
+		bool		isOperatorOf(Client& oper, Client& target);
 		std::string	trim(const std::string& str);
 
 		// for testing
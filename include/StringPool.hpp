@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <unordered_map>
+#include <cstddef>
+
+using Interned = std::shared_ptr<const std::string>;
+
+/**
+ * @brief One shared copy of each distinct string. Hostnames repeat a lot (NAT,
+ * bouncers, a test farm on localhost), the clients coming from the same host
+ * share one string instead of holding a copy each.
+ *
+ * A string is kept as long as someone holds it, the entries nobody holds
+ * anymore are swept out once the pool has doubled since the last sweep.
+ * Not thread safe, the server calls it under state_mutex_.
+ */
+class StringPool{
+	public:
+		StringPool();
+
+		Interned	intern(std::string_view str);
+		size_t		size() const;
+
+	private:
+		std::unordered_map<std::string_view, Interned>	strings_; // keys view their own value
+		size_t											next_sweep_;
+
+		void	sweep();
+
+		StringPool(const StringPool&) = delete;
+		StringPool& operator=(const StringPool&) = delete;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+
+// Resolution of the connection timers
+#define TIMER_TICK_MS (100)
+
+/**
+ * @brief Hierarchical timing wheel, one per reactor (no locking).
+ *
+ * Four levels of 64 slots: level 0 holds the timers due within 64 ticks, one
+ * slot per tick; every higher level covers 64 times the span of the previous
+ * one. When level 0 wraps around, the next slot of level 1 is cascaded down
+ * (and so on up), so every timer is moved at most three times over its
+ * lifetime. Timers are intrusive doubly linked list nodes embedded in their
+ * owner: arm() (which also re-arms) and cancel() are O(1), and so is the work
+ * per tick apart from the timers that actually expire or cascade.
+ */
+class TimerWheel{
+	public:
+		struct Timer{
+			Timer*		prev;
+			Timer*		next;
+			uint64_t	expires; // tick
+			int			fd; // owner, reported back on expiry
+
+			Timer();
+			bool	isArmed() const;
+		};
+
+		TimerWheel();
+
+		void		arm(Timer& timer, std::chrono::milliseconds delay);
+		void		cancel(Timer& timer);
+		int			msUntilNextExpiry() const;
+		bool		empty() const;
+		// Expire everything due by now, on_expire(fd) runs for each timer
+		template<typename F>
+		void		advance(F&& on_expire);
+
+	private:
+		static constexpr int		LEVELS = 4;
+		static constexpr int		SLOT_BITS = 6;
+		static constexpr int		SLOTS = 1 << SLOT_BITS;
+		static constexpr uint64_t	SLOT_MASK = SLOTS - 1;
+
+		Timer		slots_[LEVELS][SLOTS]; // list heads
+		uint64_t	next_tick_; // the first tick not processed yet
+		size_t		n_timers_;
+		std::chrono::steady_clock::time_point	origin_;
+
+		uint64_t	currentTick() const;
+		void		insert(Timer& timer);
+		bool		cascade(int level); // false when that level wrapped as well
+		static void	unlink(Timer& timer);
+
+		TimerWheel(const TimerWheel&) = delete;
+		TimerWheel& operator=(const TimerWheel&) = delete;
+};
+
+template<typename F>
+void	TimerWheel::advance(F&& on_expire){
+	uint64_t	now = currentTick();
+	while (next_tick_ <= now){
+		int	index = next_tick_ & SLOT_MASK;
+		// level 0 wrapped around: pull the next slot of the levels above down
+		if (index == 0 && !cascade(1) && !cascade(2)){
+			cascade(3);
+		}
+		next_tick_++;
+		// move the slot to a local list first, on_expire() may arm timers
+		Timer	expired;
+		Timer&	head = slots_[0][index];
+		expired.next = expired.prev = &expired;
+		if (head.next != &head){
+			expired.next = head.next;
+			expired.prev = head.prev;
+			expired.next->prev = &expired;
+			expired.prev->next = &expired;
+			head.next = head.prev = &head;
+		}
+		while (expired.next != &expired){
+			Timer*	timer = expired.next;
+			unlink(*timer);
+			n_timers_--;
+			on_expire(timer->fd);
+		}
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+
+/**
+ * @brief Flood control of one client: the bucket refills at rate tokens per
+ * second up to burst, every command takes its cost out of it. A command is
+ * let through as long as there is something left in the bucket, so an
+ * expensive command can take it below zero; the client then waits until the
+ * debt is paid back. Rate and burst are the server's, they are passed in
+ * rather than stored per client.
+ */
+class TokenBucket{
+	public:
+		TokenBucket();
+
+		void		refill(double rate, double burst, std::chrono::steady_clock::time_point now);
+		bool		hasTokens() const;
+		bool		take(int cost); // true when the bucket went into debt
+		std::chrono::milliseconds	timeUntilTokens(double rate) const;
+
+	private:
+		double									tokens_;
+		std::chrono::steady_clock::time_point	last_refill_; // epoch until the first refill()
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "EventBackend.hpp"
+#include "SendQueue.hpp"
+
+// Submission queue size, the completion queue gets four times as many entries
+#define URING_ENTRIES (1024)
+// Receive buffers shared by all the reactor's clients (power of 2)
+#define URING_RECV_BUFFERS (1024)
+#define URING_RECV_BUFFER_SIZE (4096)
+
+/**
+ * @brief Completion based backend on a raw io_uring (no liburing).
+ *
+ * - one multishot accept on the listening socket keeps producing clients;
+ * - every client has one multishot recv that picks its buffers from a ring of
+ *   provided buffers, so idle clients don't pin any memory and no recv() is
+ *   issued per readiness event;
+ * - the eventfd is watched with a multishot poll;
+ * - a send is one sendmsg() over up to SENDQ_IOV_BATCH queued payloads. The
+ *   operation holds references to them, so the bytes stay valid even when the
+ *   client is gone before the kernel is done. One send in flight per fd.
+ *
+ * Nothing is submitted right away: all the SQEs prepared during a tick go to the
+ * kernel with the io_uring_enter() that also waits for the next completions, so
+ * a loop iteration costs one syscall however many clients were served.
+ */
+class UringBackend : public EventBackend{
+	public:
+		UringBackend();
+		~UringBackend();
+
+		const char*	getName() const override;
+		void		addListener(int fd) override;
+		void		addWakeUpFd(int fd) override;
+		void		addClient(int fd) override;
+		void		removeClient(int fd) override;
+		ssize_t		send(int fd, SendQueue& queue) override;
+		void		watch(int fd, bool read, bool write) override;
+		int			wait(int timeout_ms, IoHandler& handler) override;
+
+	private:
+		// the low 3 bits of user_data tell the operation
+		enum OPTYPE{
+			OP_ACCEPT = 1,
+			OP_RECV,
+			OP_WAKEUP,
+			OP_SEND,
+			OP_CANCEL
+		};
+
+		struct SendOp{
+			int				fd;
+			uint32_t		generation;
+			Payload			refs[SENDQ_IOV_BATCH]; // keep the bytes alive
+			struct iovec	iov[SENDQ_IOV_BATCH];
+			int				n_iov;
+			int				first_iov; // iovecs before it were sent completely
+			struct msghdr	msg;
+		};
+
+		struct FdState{
+			uint32_t	generation; // bumped on removeClient(), stale completions are ignored
+			bool		send_in_flight;
+			bool		recv_armed; // the multishot recv is running
+			bool		read_paused; // watch() without read, the recv isn't re-armed
+		};
+
+		static constexpr uint16_t	BUFFER_GROUP = 0;
+
+		int						ring_fd_;
+		// submission queue
+		void*					sq_ring_;
+		size_t					sq_ring_size_;
+		unsigned*				sq_head_;
+		unsigned*				sq_tail_;
+		unsigned*				sq_mask_;
+		unsigned*				sq_array_;
+		struct io_uring_sqe*	sqes_;
+		size_t					sqes_size_;
+		unsigned				sq_entries_;
+		unsigned				sq_local_tail_; // prepared, not published yet
+		// completion queue
+		void*					cq_ring_; // same mapping as sq_ring_ with IORING_FEAT_SINGLE_MMAP
+		size_t					cq_ring_size_;
+		unsigned*				cq_head_;
+		unsigned*				cq_tail_;
+		unsigned*				cq_mask_;
+		struct io_uring_cqe*	cqes_;
+		// provided receive buffers
+		struct io_uring_buf_ring*	buf_ring_;
+		size_t					buf_ring_size_;
+		char*					buffers_;
+		uint16_t				buf_local_tail_;
+
+		int						listen_fd_;
+		int						wake_fd_;
+		std::vector<FdState>	fds_;
+		size_t					n_sends_; // SendOps the kernel still owns
+
+		struct io_uring_sqe*	getSqe();
+		void		publishSqes();
+		int			enter(unsigned min_complete, unsigned flags, void* arg, size_t arg_size);
+		void		armAccept();
+		void		armRecv(int fd);
+		void		rearmRecv(int fd);
+		void		armWakeUp();
+		void		submitSend(SendOp* op);
+		void		recycleBuffer(uint16_t buffer_id);
+		void		handleCompletion(const struct io_uring_cqe& cqe, IoHandler& handler);
+		FdState&	fdState(int fd);
+		void		cleanup();
+
+		UringBackend(const UringBackend&) = delete;
+		UringBackend& operator=(const UringBackend&) = delete;
+};
@@ -0,0 +1,56 @@
+#include "CaseMap.hpp"
+#include <array>
+
+static std::array<char, 256>	makeTable(CASEMAPPING mapping){
+	std::array<char, 256>	table;
+	for (int c = 0; c < 256; c++){
+		table[c] = static_cast<char>(c);
+	}
+	for (int c = 'A'; c <= 'Z'; c++){
+		table[c] = static_cast<char>(c - 'A' + 'a');
+	}
+	if (mapping == CASEMAPPING::RFC1459){
+		table['['] = '{';
+		table[']'] = '}';
+		table['\\'] = '|';
+		table['~'] = '^';
+	}
+	return table;
+}
+
+static const std::array<char, 256>&	tableOf(CASEMAPPING mapping){
+	static const std::array<char, 256>	rfc1459 = makeTable(CASEMAPPING::RFC1459);
+	static const std::array<char, 256>	ascii = makeTable(CASEMAPPING::ASCII);
+	return mapping == CASEMAPPING::RFC1459 ? rfc1459 : ascii;
+}
+
+std::string	CaseMap::fold(std::string_view name, CASEMAPPING mapping){
+	std::string	folded;
+	fold(name, mapping, folded);
+	return folded;
+}
+
+void	CaseMap::fold(std::string_view name, CASEMAPPING mapping, std::string& out){
+	const std::array<char, 256>&	table = tableOf(mapping);
+	out.resize(name.size());
+	for (size_t i = 0; i < name.size(); i++){
+		out[i] = table[static_cast<unsigned char>(name[i])];
+	}
+}
+
+bool	CaseMap::equals(std::string_view a, std::string_view b, CASEMAPPING mapping){
+	if (a.size() != b.size()){
+		return false;
+	}
+	const std::array<char, 256>&	table = tableOf(mapping);
+	for (size_t i = 0; i < a.size(); i++){
+		if (table[static_cast<unsigned char>(a[i])] != table[static_cast<unsigned char>(b[i])]){
+			return false;
+		}
+	}
+	return true;
+}
+
+const char*	CaseMap::getName(CASEMAPPING mapping){
+	return mapping == CASEMAPPING::RFC1459 ? "rfc1459" : "ascii";
+}
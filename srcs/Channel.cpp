@@ -12,25 +12,46 @@
 
 #include "Channel.hpp"
 
-Channel::Channel(const std::string& name, Client& user) : channel_name_(name) {
+Channel::Channel(const std::string& name, std::string key, Client& user)
+    : channel_name_(name), channel_key_(std::move(key)) {
     channel_passwd_ = "";
     channel_topic_ = "";
     channel_invite_only_ = false;
     channel_restric_topic_ = false;
     channel_with_passwd_ = false;
     channel_user_limit_ = false;
+    channel_auditorium_ = false;
     user_limit_ = 0;
+    names_valid_ = true;
     addNewUser(user);
     addNewOperator(user);
 }
 
+/**
+ * @brief A channel is removed once its last member left, the clients that are
+ * still invited forget it.
+ */
 Channel::~Channel(){
+    for (auto& member : members_){
+        if (Client* user = Server::getClient(member.client)){
+            user->removeChannel(this);
+        }
+    }
+    for (const auto& handle : invited_users_){
+        if (Client* user = Server::getClient(handle)){
+            user->removeInvite(this);
+        }
+    }
 }
 
 const std::string& Channel::getName() const{
     return channel_name_;
 }
 
+const std::string& Channel::getKey() const{
+    return channel_key_;
+}
+
 const std::string& Channel::getPassword() const{
     return channel_passwd_;
 }
@@ -55,12 +76,24 @@ bool    Channel::getLimitMode() const{
     return channel_user_limit_;
 }
 
+bool    Channel::getAuditoriumMode() const{
+    return channel_auditorium_;
+}
+
 size_t  Channel::channelSize(){
-    return users_.size();
+    return members_.size();
 }
 
-const std::unordered_set<Client*>&  Channel::getChannelUsers() const{
-    return users_;
+const std::vector<ChannelMember>&   Channel::getChannelUsers() const{
+    return members_;
+}
+
+ChannelMember*  Channel::findMember(const Client& user){
+    auto it = member_index_.find(user.getHandle());
+    if (it == member_index_.end()){
+        return nullptr;
+    }
+    return &members_[it->second];
 }
 
 // Channel's set mode:
@@ -73,7 +106,15 @@ void    Channel::unsetInviteOnly(){
 }
 
 void    Channel::addNewInviteUser(Client& user){
-    invited_users_.insert(&user);
+    if (invited_users_.insert(user.getHandle()).second){
+        user.addInvite(this);
+    }
+}
+
+void    Channel::removeInviteUser(Client& user){
+    if (invited_users_.erase(user.getHandle()) > 0){
+        user.removeInvite(this);
+    }
 }
 
 void    Channel::setTopicRestrictions(){
@@ -112,6 +153,14 @@ void    Channel::addLimit(int limit){
 	user_limit_ = limit;
 }
 
+void    Channel::setAuditorium(){
+    channel_auditorium_ = true;
+}
+
+void    Channel::unsetAuditorium(){
+    channel_auditorium_ = false;
+}
+
 // Regular user and Channel Operator:
 
 /**
@@ -130,10 +179,14 @@ void    Channel::addLimit(int limit){
 void    Channel::addNewUser(Client& user){
     int fd = user.getSocketFd();
 
-    if (channel_invite_only_) {
-        invited_users_.erase(&user);
+    if (channel_invite_only_ && invited_users_.erase(user.getHandle()) > 0) {
+        user.removeInvite(this);
+    }
+    if (member_index_.emplace(user.getHandle(), members_.size()).second){
+        members_.push_back(ChannelMember{user.getHandle(), 0});
+        user.addChannel(this);
+        appendName(user, 0);
     }
-    users_.insert(&user);
     Logger::log(Logger::INFO, "User " + std::to_string(fd) + " joined " + channel_name_);
 }
 
@@ -142,38 +195,61 @@ void    Channel::addNewUser(Client& user){
  *
  * This function removes the given user from the set of current channel members.
  * If the user is also listed as an operator or in the invite list, those entries are cleared as well.
+ * The user's own list of channels (Client::getChannels()) is kept in step.
  *
  * @param user The client to be removed from the channel.
  */
 void    Channel::removeUser(Client& user){
     int fd = user.getSocketFd();
-    if (users_.erase(&user) > 0){
-        operators_.erase(&user);
-        invited_users_.erase(&user);
+    removeInviteUser(user);
+    auto it = member_index_.find(user.getHandle());
+    if (it != member_index_.end()){
+        // the last member takes the freed place, the array stays packed
+        size_t  pos = it->second;
+        member_index_.erase(it);
+        if (pos != members_.size() - 1){
+            members_[pos] = members_.back();
+            member_index_[members_[pos].client] = pos;
+        }
+        members_.pop_back();
+        user.removeChannel(this);
+        invalidateNames();
 		Logger::log(Logger::INFO, "User " + std::to_string(fd) + " left " + channel_name_);
 	}
 	else
 		Logger::log(Logger::WARNING, "Attempted to remove user " + std::to_string(fd) + " who is not in " + channel_name_);
 }
 
+/**
+ * @brief Only members can be operators.
+ */
 void    Channel::addNewOperator(Client& user){
-    operators_.insert(&user);
+    ChannelMember*  member = findMember(user);
+    if (member && !(member->modes & ChannelMember::OPERATOR)){
+        member->modes |= ChannelMember::OPERATOR;
+        invalidateNames();
+    }
 }
 
 void    Channel::removeOperator(Client& user){
-    operators_.erase(&user);
+    ChannelMember*  member = findMember(user);
+    if (member && (member->modes & ChannelMember::OPERATOR)){
+        member->modes &= ~ChannelMember::OPERATOR;
+        invalidateNames();
+    }
 }
 
 bool    Channel::isChannelUser(Client& user){
-    return users_.find(&user) != users_.end();
+    return member_index_.find(user.getHandle()) != member_index_.end();
 }
 
 bool    Channel::isChannelOperator(Client& user){
-    return operators_.find(&user) != operators_.end();
+    ChannelMember*  member = findMember(user);
+    return member && (member->modes & ChannelMember::OPERATOR);
 }
 
 bool    Channel::isInvitedUser(Client& user){
-    return invited_users_.find(&user) != invited_users_.end();
+    return invited_users_.find(user.getHandle()) != invited_users_.end();
 }
 
 /**
@@ -183,11 +259,12 @@ bool    Channel::isInvitedUser(Client& user){
  * channel earliest
  */
 bool    Channel::isThereOperatorInChannel(){
-    if (operators_.empty() == true){
-        return false;
-    } else {
-        return true;
+    for (const auto& member : members_){
+        if (member.modes & ChannelMember::OPERATOR){
+            return true;
+        }
     }
+    return false;
 }
 
 // General:
@@ -197,17 +274,55 @@ bool    Channel::isThereOperatorInChannel(){
  *
  * @param target The user to exclude from receiving the message.
  * @param msg The message to send to the other users in the channel.
+ * @param traffic DROPPABLE for chatter a lagging member may miss.
+ */
+void    Channel::notifyChannelUsers(Client& target, const std::string& msg, TRAFFIC traffic){
+    notifyChannelUsers(target, makePayload(msg), traffic);
+}
+
+/**
+ * @brief Same as above for a message that is already serialized. All the
+ * members share the one payload, nobody gets a copy.
  */
-void    Channel::notifyChannelUsers(Client& target, const std::string& msg){
-    for (auto user : users_){
-        if (user == &target) // do not notify target
+void    Channel::notifyChannelUsers(Client& target, const Payload& payload, TRAFFIC traffic){
+    for (const auto& member : members_){
+        if (member.client == target.getHandle()) // do not notify target
             continue ;
-        Server::responseToClient(*user, msg);
+        if (Client* user = Server::getClient(member.client)){
+            Server::responseToClient(*user, payload, traffic);
+        }
     }
 }
 
+/**
+ * @brief Send a JOIN or PART of target. In a +u channel only the operators
+ * hear about the regular members coming and going, which keeps a reconnect
+ * storm into a big channel from costing O(n) messages per member.
+ */
+void    Channel::notifyMembershipChange(Client& target, const Payload& payload){
+    if (!isHiddenMember(target)){
+        notifyChannelUsers(target, payload);
+        return;
+    }
+    for (const auto& member : members_){
+        if (member.client == target.getHandle() || !(member.modes & ChannelMember::OPERATOR))
+            continue ;
+        if (Client* user = Server::getClient(member.client)){
+            Server::responseToClient(*user, payload);
+        }
+    }
+}
+
+/**
+ * @brief Whether the regular members don't see user: the channel is +u and
+ * user isn't one of its operators.
+ */
+bool    Channel::isHiddenMember(Client& user){
+    return channel_auditorium_ && !isChannelOperator(user);
+}
+
 bool    Channel::isEmptyChannel(){
-    return users_.empty();
+    return members_.empty();
 }
 
 bool    Channel::isFullChannel(){
@@ -222,15 +337,15 @@ bool    Channel::isFullChannel(){
  * @param user The user to add.
  * @param type The user type (regular, operator, or invited).
  */
-void    Channel::insertUser(std::shared_ptr<Client> user, USERTYPE type){
+void    Channel::insertUser(Client& user, USERTYPE type){
     if (type == USERTYPE::REGULAR){
-        addNewUser(*user);
+        addNewUser(user);
     }
     if (type == USERTYPE::OPERATOR){
-        addNewOperator(*user);
+        addNewOperator(user);
     }
     if (type == USERTYPE::INVITE){
-        addNewInviteUser(*user);
+        addNewInviteUser(user);
     }
 }
 
@@ -263,13 +378,86 @@ bool    Channel::isUserInList(Client& user, USERTYPE type){
  * role to the first user
  */
 Client*     Channel::getTheFirstUser() const{
-    if (users_.empty() == false){
-        return *(users_.begin());
+    if (members_.empty() == false){
+        return Server::getClient(members_.front().client);
     } else {
         return nullptr;
     }
 }
 
+// NAMES:
+
+/**
+ * @brief Add one name to the last list, or start a new list when it would
+ * not fit in budget. A list always takes at least one name.
+ */
+static void appendTo(std::vector<std::string>& lists, const std::string& nick, bool is_operator, size_t budget){
+    size_t  len = nick.size() + (is_operator ? 1 : 0);
+
+    if (lists.empty() || lists.back().size() + 1 + len > budget){
+        lists.emplace_back();
+    }
+    std::string&    names = lists.back();
+    if (!names.empty()){
+        names += ' ';
+    }
+    if (is_operator){
+        names += '@';
+    }
+    names += nick;
+}
+
+/**
+ * @brief The names of the members for RPL_NAMREPLY, already split so that
+ * every 353 line stays within IRC_LINE_MAX whatever the requester's nick.
+ * With operators_only, just the operators: what a regular member is shown of
+ * a +u channel, next to its own name.
+ * A join appends to the last list, anything else that changes what the
+ * lists show (a part, a kick, an op change, a nick change) only drops them
+ * and the next call rebuilds them in one pass.
+ */
+const std::vector<std::string>&   Channel::getNames(bool operators_only){
+    if (!names_valid_){
+        names_.clear();
+        operator_names_.clear();
+        names_valid_ = true;
+        for (const auto& member : members_){
+            if (Client* user = Server::getClient(member.client)){
+                appendName(*user, member.modes);
+            }
+        }
+    }
+    return operators_only ? operator_names_ : names_;
+}
+
+void    Channel::invalidateNames(){
+    names_valid_ = false;
+}
+
+/**
+ * @brief How long a list of names can be for its 353 line to fit in
+ * IRC_LINE_MAX, whatever the requester's nick.
+ */
+size_t  Channel::namesBudget() const{
+    // ":server 353 <nick> = <channel> :<names>\r\n"
+    const size_t    overhead = sizeof(":" SERVER " 353 ") - 1 + NICK_MAX_LEN
+                        + sizeof(" = ") - 1 + channel_name_.size() + sizeof(" :") - 1
+                        + sizeof(CRLF) - 1;
+    return overhead < IRC_LINE_MAX ? IRC_LINE_MAX - overhead : 0;
+}
+
+void    Channel::appendName(const Client& user, uint8_t modes){
+    if (!names_valid_){
+        return;
+    }
+    const size_t    budget = namesBudget();
+    bool            is_operator = modes & ChannelMember::OPERATOR;
+
+    appendTo(names_, user.getNick(), is_operator, budget);
+    if (is_operator){
+        appendTo(operator_names_, user.getNick(), true, budget);
+    }
+}
 
 // for testing only
 #if 0
@@ -290,15 +478,19 @@ void    Channel::printUsers(USERTYPE type) const{
     switch (type){
     case USERTYPE::REGULAR:
         std::cout << "channel users are: ";
-         list = users_;
+        for (const auto& member : members_)
+            list.insert(Server::getClient(member.client));
         break;
     case USERTYPE::OPERATOR:
         std::cout << "channel operators are: ";
-        list = operators_;
+        for (const auto& member : members_)
+            if (member.modes & ChannelMember::OPERATOR)
+                list.insert(Server::getClient(member.client));
         break;
     case USERTYPE::INVITE:
         std::cout << "channel invitees are: ";
-        list = invited_users_;
+        for (const auto& handle : invited_users_)
+            list.insert(Server::getClient(handle));
         break;
     }
     for (const auto& user : list){
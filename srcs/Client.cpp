@@ -11,25 +11,73 @@
 /* ************************************************************************** */
 
 #include "Client.hpp"
+#include <algorithm>
+#include <functional>
 
-Client::Client() : socket_fd_(0), isRegistered_(0), n_usr_channel_(0){}
+bool	ClientHandle::operator==(const ClientHandle& other) const{
+	return fd == other.fd && reactor == other.reactor && generation == other.generation;
+}
+
+bool	ClientHandle::operator!=(const ClientHandle& other) const{
+	return !(*this == other);
+}
+
+size_t	ClientHandleHash::operator()(const ClientHandle& handle) const{
+	// fds are unique among the live clients, the rest tells the stale apart
+	return std::hash<uint64_t>()((uint64_t(handle.generation) << 32 | uint32_t(handle.fd))
+		^ (uint64_t(handle.reactor) << 48));
+}
 
-Client::Client(int fd, std::string host) : socket_fd_(fd), hostname_(host),
-isRegistered_(0), n_usr_channel_(0){
+Client::Client() : handle_{-1, 0, 0}, hostname_(std::make_shared<const std::string>()), isRegistered_(0), fanout_mark_(0),
+watching_write_(false), watching_read_(true), in_flush_list_(false), in_ready_list_(false), corked_(false),
+marked_for_disconnect_(false), lagged_(false), n_dropped_(0), conn_state_(CONNSTATE::REGISTERING),
+last_activity_(std::chrono::steady_clock::now()), last_command_(last_activity_), ping_sent_(last_activity_), throttled_(false),
+flood_points_(0), caps_(0){}
+
+Client::Client(ClientHandle handle, Interned host) : handle_(handle), hostname_(std::move(host)),
+isRegistered_(0), fanout_mark_(0), watching_write_(false), watching_read_(true), in_flush_list_(false),
+in_ready_list_(false), corked_(false), marked_for_disconnect_(false), lagged_(false),
+n_dropped_(0), conn_state_(CONNSTATE::REGISTERING), last_activity_(std::chrono::steady_clock::now()),
+last_command_(last_activity_), ping_sent_(last_activity_), throttled_(false),
+flood_points_(0), caps_(0){
+	timer_.fd = handle.fd;
+	flood_timer_.fd = handle.fd;
+	updatePrefix();
 }
 
 Client&	Client::operator=(const Client& other){
 	if (this != & other){
-		socket_fd_ = other.socket_fd_;
+		handle_ = other.handle_;
         nick_ = other.nick_;
         username_ = other.username_;
         realname_ = other.realname_;
         hostname_ = other.hostname_;
+        prefix_ = other.prefix_;
         servername_ = other.servername_;
         password_ = other.password_;
-        raw_data_ = other.raw_data_;
+        recv_buffer_ = other.recv_buffer_;
         isRegistered_ = other.isRegistered_;
-        n_usr_channel_ = other.n_usr_channel_;
+        channels_ = other.channels_;
+        invites_ = other.invites_;
+        fanout_mark_ = other.fanout_mark_;
+        send_queue_ = other.send_queue_;
+        watching_write_ = other.watching_write_;
+        watching_read_ = other.watching_read_;
+        in_flush_list_ = other.in_flush_list_;
+        in_ready_list_ = other.in_ready_list_;
+        corked_ = other.corked_;
+        marked_for_disconnect_ = other.marked_for_disconnect_;
+        disconnect_reason_ = other.disconnect_reason_;
+        lagged_ = other.lagged_;
+        n_dropped_ = other.n_dropped_;
+        conn_state_ = other.conn_state_;
+        last_activity_ = other.last_activity_;
+        last_command_ = other.last_command_;
+        ping_sent_ = other.ping_sent_;
+        flood_bucket_ = other.flood_bucket_;
+        throttled_ = other.throttled_;
+        flood_points_ = other.flood_points_;
+        caps_ = other.caps_;
 	}
 	return *this;
 }
@@ -38,7 +86,15 @@ Client::~Client(){
 }
 
 int Client::getSocketFd() const{
-	return socket_fd_;
+	return handle_.fd;
+}
+
+const ClientHandle&	Client::getHandle() const{
+	return handle_;
+}
+
+int	Client::getReactorId() const{
+	return handle_.reactor;
 }
 
 const std::string&	Client::getUsername() const{
@@ -50,7 +106,7 @@ const std::string&	Client::getRealname() const{
 }
 
 const std::string&	Client::getHostname() const{
-    return hostname_;
+    return *hostname_;
 }
 
 const std::string&	Client::getNick() const{
@@ -66,7 +122,11 @@ const std::string&	Client::getUserMode() const{
 }
 
 int	Client::getUserNChannel() const{
-    return n_usr_channel_;
+    return channels_.size();
+}
+
+const std::string&	Client::getDisconnectReason() const{
+    return disconnect_reason_;
 }
 
 /**
@@ -76,26 +136,44 @@ int	Client::getUserNChannel() const{
  *
  * Server responds with:
  *    :alice!alice@hostname PRIVMSG bob :Hello, Bob!
+ *
+ * It goes out with every JOIN, PART, QUIT and NICK, so it is built once by the
+ * setters of its parts rather than on every call. The reference changes with
+ * them: keep a copy to use the old prefix after setNick().
  */
-std::string	Client::getPrefix() const{
-	return (":" + nick_ + "!~" + username_ + "@" + hostname_);
+const std::string&	Client::getPrefix() const{
+	return prefix_;
+}
+
+void	Client::updatePrefix(){
+	prefix_.clear();
+	prefix_.reserve(nick_.size() + username_.size() + hostname_->size() + 4);
+	prefix_ += ':';
+	prefix_ += nick_;
+	prefix_ += "!~";
+	prefix_ += username_;
+	prefix_ += '@';
+	prefix_ += *hostname_;
 }
 
 
 void	Client::setNick(const std::string& nick){
     nick_ = nick;
+    updatePrefix();
 }
 
 void	Client::setUsername(const std::string& username){
     username_ = username;
+    updatePrefix();
 }
 
 void	Client::setRealname(const std::string& realname){
     realname_ = realname;
 }
 
-void	Client::setHostname(const std::string& hostname){
-    hostname_ = hostname;
+void	Client::setHostname(Interned hostname){
+    hostname_ = std::move(hostname);
+    updatePrefix();
 }
 
 void	Client::setServername(const std::string& servername){
@@ -114,30 +192,29 @@ void	Client::setUserMode(const std::string& mode){
     user_mode_ = mode;
 }
 
-void	Client::increaseUserNchannel(){
-    n_usr_channel_++;
-}
 
 
 /**
- * @brief Receive the raw data from socket, filling/saving into receive buffer.
+ * @brief Receive the raw data from socket straight into the receive buffer.
+ * Stops after about budget bytes, the rest stays in the socket; epoll reports
+ * the socket readable again on the next tick.
  *
  * @return
  *  True, read successful;
  *  False, some error;
  *
  */
-bool	Client::receiveRawData(){
-	char buffer[BUFFER_SIZE + 1];
-    ssize_t bytes_read;
+bool	Client::receiveRawData(size_t budget){
+    size_t  total = 0;
 
-    std::memset(buffer, 0, sizeof(buffer));
-    while (true) {
-        bytes_read = recv(socket_fd_, buffer, BUFFER_SIZE, 0);
+    while (total < budget) {
+        char*   dst = recv_buffer_.prepareWrite(RECVBUF_CHUNK);
+        size_t  room = std::min(recv_buffer_.writable(), budget - total);
+        ssize_t bytes_read = recv(handle_.fd, dst, room, 0);
 
         if (bytes_read > 0) {
-            std::cout << "Received data:" << buffer << std::endl;
-            raw_data_.append(buffer, bytes_read);
+            recv_buffer_.commitWrite(bytes_read);
+            total += bytes_read;
         } else if (bytes_read == 0) {
             // Connection closed
             return false;
@@ -145,7 +222,7 @@ bool	Client::receiveRawData(){
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 // All data read
                 break;
-            } else {
+            } else if (errno != EINTR) {
                 // Other errors
                 perror("recv");
                 return false;
@@ -156,53 +233,265 @@ bool	Client::receiveRawData(){
 }
 
 /**
- * @brief Gets the next CRLF separated(IRC rule) message from the receive raw data
- * and stores it into passed paramenter buffer.
+ * @brief Append data the event backend already received from the socket.
+ */
+void	Client::appendRawData(const char* data, size_t len){
+	recv_buffer_.append(data, len);
+}
+
+/**
+ * @brief Gets the next CRLF separated(IRC rule, a bare LF works too) message from the received data.
  *
  * @param
- * buffer to store the message in
+ * line: set to the message (including its CRLF or LF). It points into the receive
+ * buffer and stays valid until the next receive.
  *
  * @return
  * true: if successfully get the message
- * false: raw data is empty.
+ * false: no complete message yet.
  */
-bool	Client::getNextMessage(std::string& buffer){
-	// Find the position of CRLF ("\r\n") in raw_data_
-    size_t crlf_pos = raw_data_.find("\r\n");
+bool	Client::getNextMessage(std::string_view& line){
+    return recv_buffer_.nextLine(line);
+}
 
-    if (crlf_pos == std::string::npos) {
-        // No complete message yet
-        return false;
-    }
+/**
+ * @brief Whether a complete line is waiting in the receive buffer.
+ */
+bool	Client::hasNextMessage(){
+	return recv_buffer_.hasLine();
+}
 
-    // Extract the message (including CRLF)
-    buffer = raw_data_.substr(0, crlf_pos + 2);
+bool	Client::isRegistered(){
+	return isRegistered_;
+}
 
-    // Remove the processed message from raw_data_
-    raw_data_.erase(0, crlf_pos + 2);
+/**
+ * @brief Put a reply at the end of the client's send queue.
+ *
+ * @return false if the send queue is full, the reply is not queued then.
+ */
+bool	Client::queueResponse(const Payload& payload){
+	return send_queue_.push(payload);
+}
 
-    return true;
+SendQueue&	Client::getSendQueue(){
+	return send_queue_;
 }
 
-bool	Client::isRegistered(){
-	return isRegistered_;
+bool	Client::hasPendingOutput() const{
+	return !send_queue_.empty();
+}
+
+bool	Client::isWatchingWrite() const{
+	return watching_write_;
+}
+
+bool	Client::isWatchingRead() const{
+	return watching_read_;
+}
+
+void	Client::setWatchingRead(bool status){
+	watching_read_ = status;
+}
+
+void	Client::setWatchingWrite(bool status){
+	watching_write_ = status;
+}
+
+bool	Client::isInFlushList() const{
+	return in_flush_list_;
+}
+
+void	Client::setInFlushList(bool status){
+	in_flush_list_ = status;
+}
+
+bool	Client::isInReadyList() const{
+	return in_ready_list_;
+}
+
+void	Client::setInReadyList(bool status){
+	in_ready_list_ = status;
+}
+
+bool	Client::isCorked() const{
+	return corked_;
+}
+
+void	Client::setCorked(bool status){
+	corked_ = status;
+}
+
+/**
+ * @brief Flag the client to be removed once the server finished the current
+ * batch of events. Used where removing the client right away would break the
+ * caller, e.g. in the middle of a channel broadcast.
+ */
+void	Client::markForDisconnect(const std::string& reason){
+	if (!marked_for_disconnect_){
+		marked_for_disconnect_ = true;
+		disconnect_reason_ = reason;
+	}
+}
+
+bool	Client::isMarkedForDisconnect() const{
+	return marked_for_disconnect_;
+}
+
+bool	Client::isLagged() const{
+	return lagged_;
+}
+
+void	Client::setLagged(bool status){
+	lagged_ = status;
+}
+
+void	Client::countDropped(){
+	n_dropped_++;
+}
+
+/**
+ * @brief The number of payloads dropped since the last call.
+ */
+size_t	Client::takeDropped(){
+	size_t	n = n_dropped_;
+	n_dropped_ = 0;
+	return n;
+}
+
+TimerWheel::Timer&	Client::getTimer(){
+	return timer_;
+}
+
+CONNSTATE	Client::getConnState() const{
+	return conn_state_;
+}
+
+void	Client::setConnState(CONNSTATE state){
+	conn_state_ = state;
+}
+
+/**
+ * @brief Record that a line arrived. The timer isn't touched, it checks these
+ * timestamps when it fires, so a busy client costs nothing per line.
+ */
+void	Client::touch(std::chrono::steady_clock::time_point now, bool is_command){
+	last_activity_ = now;
+	if (is_command){
+		last_command_ = now;
+	}
+}
+
+std::chrono::steady_clock::time_point	Client::getLastActivity() const{
+	return last_activity_;
+}
+
+std::chrono::steady_clock::time_point	Client::getLastCommand() const{
+	return last_command_;
+}
+
+std::chrono::steady_clock::time_point	Client::getPingSent() const{
+	return ping_sent_;
+}
+
+void	Client::setPingSent(std::chrono::steady_clock::time_point when){
+	ping_sent_ = when;
+}
+
+const std::vector<Channel*>&	Client::getChannels() const{
+	return channels_;
+}
+
+const std::vector<Channel*>&	Client::getInvites() const{
+	return invites_;
+}
+
+void	Client::addChannel(Channel* channel){
+	channels_.push_back(channel);
+}
+
+/**
+ * @brief Order doesn't matter, the last entry takes the place of the removed one.
+ */
+void	Client::removeChannel(Channel* channel){
+	auto	it = std::find(channels_.begin(), channels_.end(), channel);
+	if (it != channels_.end()){
+		*it = channels_.back();
+		channels_.pop_back();
+	}
+}
+
+void	Client::addInvite(Channel* channel){
+	invites_.push_back(channel);
+}
+
+void	Client::removeInvite(Channel* channel){
+	auto	it = std::find(invites_.begin(), invites_.end(), channel);
+	if (it != invites_.end()){
+		*it = invites_.back();
+		invites_.pop_back();
+	}
+}
+
+bool	Client::visit(uint64_t epoch){
+	if (fanout_mark_ == epoch){
+		return false;
+	}
+	fanout_mark_ = epoch;
+	return true;
+}
+
+TokenBucket&	Client::getFloodBucket(){
+	return flood_bucket_;
+}
+
+TimerWheel::Timer&	Client::getFloodTimer(){
+	return flood_timer_;
+}
+
+bool	Client::isThrottled() const{
+	return throttled_;
+}
+
+void	Client::setThrottled(bool status){
+	throttled_ = status;
+}
+
+uint64_t	Client::getFloodPoints() const{
+	return flood_points_;
+}
+
+void	Client::addFloodPoints(uint64_t points){
+	flood_points_ += points;
+}
+
+bool	Client::hasCap(uint8_t cap) const{
+	return (caps_ & cap) != 0;
+}
+
+uint8_t	Client::getCaps() const{
+	return caps_;
+}
+
+void	Client::setCaps(uint8_t caps){
+	caps_ = caps;
 }
 
 #if 0
 // for testing only
 void	Client::printInfo() const{
     std::cout << "User info:\n";
-    std::cout << "  fd:" << socket_fd_ << std::endl;
+    std::cout << "  fd:" << handle_.fd << std::endl;
     std::cout << "  nick:" << nick_ << std::endl;
     std::cout << "  username:" << username_ << std::endl;
     std::cout << "  realname:" << realname_ << std::endl;
-    std::cout << "  hostname:" << hostname_ << std::endl;
+    std::cout << "  hostname:" << *hostname_ << std::endl;
     std::cout << "  servername:" << servername_ << std::endl;
     std::cout << "  password:" << password_ << std::endl;
     std::cout << "  isRegistered:" << isRegistered_ << std::endl;
 }
 
 void    Client::printRawData() const{
-    std::cout << "rawdata:" << raw_data_ << std::endl;
+    std::cout << "rawdata:" << recv_buffer_.size() << " bytes" << std::endl;
 }
 #endif
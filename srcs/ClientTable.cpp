@@ -0,0 +1,88 @@
+#include "ClientTable.hpp"
+#include <stdexcept>
+#include <sys/resource.h>
+
+// fd limit assumed when the process has none
+#define MAX_TABLE_FDS (1 << 20)
+
+ClientTable::ClientTable(int reactor_id) : reactor_id_(reactor_id), n_clients_(0){
+	rlimit	limit;
+	size_t	max_fds = MAX_TABLE_FDS;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+		&& limit.rlim_cur < max_fds){
+		max_fds = limit.rlim_cur;
+	}
+	chunks_.resize((max_fds + CHUNK_SIZE - 1) / CHUNK_SIZE);
+}
+
+ClientTable::Slot*	ClientTable::findSlot(int fd) const{
+	size_t	chunk = static_cast<size_t>(fd) >> CHUNK_BITS;
+	if (fd < 0 || chunk >= chunks_.size() || !chunks_[chunk]){
+		return nullptr;
+	}
+	return &chunks_[chunk][fd & (CHUNK_SIZE - 1)];
+}
+
+/**
+ * @brief Construct the client in the slot of fd. A client removed from that
+ * slot earlier in the tick is destroyed now.
+ */
+Client&	ClientTable::add(int fd, Interned host){
+	size_t	chunk = static_cast<size_t>(fd) >> CHUNK_BITS;
+	if (fd < 0 || chunk >= chunks_.size()){
+		throw std::runtime_error("Error: fd " + std::to_string(fd) + " is over the fd limit");
+	}
+	if (!chunks_[chunk]){
+		chunks_[chunk] = std::make_unique<Slot[]>(CHUNK_SIZE);
+	}
+	Slot&	slot = chunks_[chunk][fd & (CHUNK_SIZE - 1)];
+	slot.generation++;
+	slot.client.emplace(ClientHandle{fd, static_cast<uint16_t>(reactor_id_), slot.generation}, std::move(host));
+	slot.live = true;
+	n_clients_++;
+	return *slot.client;
+}
+
+void	ClientTable::remove(Client& cli){
+	Slot*	slot = findSlot(cli.getSocketFd());
+	if (!slot || !slot->live || slot->generation != cli.getHandle().generation){
+		return;
+	}
+	slot->live = false;
+	removed_.push_back(cli.getSocketFd());
+	n_clients_--;
+}
+
+Client*	ClientTable::get(int fd) const{
+	Slot*	slot = findSlot(fd);
+	if (!slot || !slot->live){
+		return nullptr;
+	}
+	return &*slot->client;
+}
+
+Client*	ClientTable::get(const ClientHandle& handle) const{
+	Slot*	slot = findSlot(handle.fd);
+	if (!slot || !slot->live || slot->generation != handle.generation){
+		return nullptr;
+	}
+	return &*slot->client;
+}
+
+size_t	ClientTable::size() const{
+	return n_clients_;
+}
+
+/**
+ * @brief Destroy the clients removed since the last call, their memory (send
+ * and receive buffers) is given back. The slots stay for the next fds.
+ */
+void	ClientTable::collect(){
+	for (int fd : removed_){
+		Slot*	slot = findSlot(fd);
+		if (slot && !slot->live){
+			slot->client.reset();
+		}
+	}
+	removed_.clear();
+}
@@ -0,0 +1,93 @@
+#include "CommandTable.hpp"
+#include <array>
+#include <cstddef>
+
+using CI = CommandInfo;
+
+/**
+ * @brief In the order of COMMANDTYPE. Lookups that walk all the users or
+ * channels, and the commands that make the server broadcast, cost more; PONG
+ * and QUIT are free, answering the server's PING or leaving never counts as
+ * flooding.
+ */
+static constexpr std::array<CommandInfo, INVALID + 1>	COMMANDS = {{
+	{"PASS",    PASS,    CI::BEFORE_PASS | CI::BEFORE_REGISTRATION, 1},
+	{"NICK",    NICK,    CI::BEFORE_REGISTRATION, 3},
+	{"USER",    USER,    CI::BEFORE_REGISTRATION, 1},
+	{"PRIVMSG", PRIVMSG, 0, 1},
+	{"JOIN",    JOIN,    0, 5},
+	{"PART",    PART,    0, 2},
+	{"KICK",    KICK,    0, 2},
+	{"INVITE",  INVITE,  0, 2},
+	{"TOPIC",   TOPIC,   0, 2},
+	{"MODE",    MODE,    0, 2},
+	{"QUIT",    QUIT,    CI::BEFORE_REGISTRATION, 0},
+	{"CAP",     CAP,     CI::BEFORE_PASS | CI::BEFORE_REGISTRATION, 1},
+	{"PING",    PING,    CI::BEFORE_PASS | CI::BEFORE_REGISTRATION, 1},
+	{"PONG",    PONG,    CI::BEFORE_PASS | CI::BEFORE_REGISTRATION, 0},
+	{"WHOIS",   WHOIS,   CI::BEFORE_PASS | CI::BEFORE_REGISTRATION, 3},
+	{"WHO",     WHO,     CI::BEFORE_REGISTRATION, 5},
+	{"NAMES",   NAMES,   0, 2},
+	{"",        INVALID, 0, 1}
+}};
+
+static constexpr size_t	SLOT_BITS = 5;
+static constexpr size_t	N_SLOTS = size_t(1) << SLOT_BITS;
+static constexpr size_t	MIN_NAME = 3;
+static constexpr size_t	MAX_NAME = 7;
+
+/**
+ * @brief The slot of a name of MIN_NAME..MAX_NAME bytes. The factors were
+ * picked so the names of COMMANDS don't collide, the static_assert below
+ * says when a new command needs other ones.
+ */
+static constexpr size_t	slotOf(std::string_view name){
+	return (static_cast<unsigned char>(name[0])
+		+ static_cast<unsigned char>(name[1]) * 10
+		+ static_cast<unsigned char>(name[name.size() - 1]) * 2
+		+ name.size()) & (N_SLOTS - 1);
+}
+
+// the slot table, INVALID where no command hashes to
+static constexpr std::array<COMMANDTYPE, N_SLOTS>	makeSlots(){
+	std::array<COMMANDTYPE, N_SLOTS>	slots{};
+	for (auto& slot : slots){
+		slot = INVALID;
+	}
+	for (const auto& command : COMMANDS){
+		if (command.type != INVALID){
+			slots[slotOf(command.name)] = command.type;
+		}
+	}
+	return slots;
+}
+
+static constexpr std::array<COMMANDTYPE, N_SLOTS>	SLOTS = makeSlots();
+
+static constexpr bool	isPerfect(){
+	for (size_t i = 0; i < COMMANDS.size(); i++){
+		const CommandInfo&	command = COMMANDS[i];
+		if (command.type != static_cast<COMMANDTYPE>(i)){
+			return false;
+		}
+		if (command.type != INVALID && (command.name.size() < MIN_NAME
+			|| command.name.size() > MAX_NAME || SLOTS[slotOf(command.name)] != command.type)){
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(isPerfect(), "COMMANDS is out of COMMANDTYPE order, or two names share a slot of slotOf()");
+
+COMMANDTYPE	CommandTable::lookup(std::string_view name){
+	if (name.size() < MIN_NAME || name.size() > MAX_NAME){
+		return INVALID;
+	}
+	COMMANDTYPE	type = SLOTS[slotOf(name)];
+	return COMMANDS[type].name == name ? type : INVALID;
+}
+
+const CommandInfo&	CommandTable::get(COMMANDTYPE type){
+	return COMMANDS[type];
+}
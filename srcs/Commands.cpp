@@ -25,7 +25,7 @@ void	Server::passCommand(Message& msg, Client& cli){
 	}
 	// vector.at() is safer than vector.at[0] to access the element.
 	// at() will do the bounds checking
-	std::string	password = msg.getParameters().at(0);
+	std::string	password(msg.getParameters().at(0));
 	if (isPasswordMatch(password) == false){
 		Logger::log(Logger::WARNING, "Password doesn't match");
 		responseToClient(cli, passwdMismatch(nick));
@@ -57,14 +57,19 @@ void	Server::attempRegisterClient(Client& cli){
 		return;
 	}
 	cli.setRegistrationStatus(true);
+	nicks_[foldNick(nick)] = &cli;
+	cli.setConnState(CONNSTATE::ACTIVE);
+	armClientTimer(cli);
 	responseToClient(cli, rplWelcome(nick, cli.getPrefix()));
 	responseToClient(cli,rplYourHost(nick));
 	responseToClient(cli,rplCreated(nick));
 	responseToClient(cli,rplMyInfo(nick));
+	responseToClient(cli,rplISupport(nick, CaseMap::getName(config_.casemapping)));
 }
 
 /**
- * @brief Checking if the passed nick is in use
+ * @brief Checking if the passed nick is in use, nicks differing only in case
+ * (under the server's casemapping) are the same.
  *
  * @param nick The nickname to be checked
  *
@@ -73,12 +78,15 @@ void	Server::attempRegisterClient(Client& cli){
  * - `false`: The nickname is available
  */
 bool Server::isNickInUse(const std::string& nick, const Client* requesting_client){
-	for (auto& [fd, user] : clients_){
-		if (user->getNick() == nick && user->isRegistered() && user.get() != requesting_client){
-			return true;
-		}
-	}
-	return false;
+	auto	it = nicks_.find(foldNick(nick));
+	return it != nicks_.end() && it->second != requesting_client;
+}
+
+/**
+ * @brief The key of the nick in nicks_.
+ */
+std::string	Server::foldNick(std::string_view nick) const{
+	return CaseMap::fold(nick, config_.casemapping);
 }
 
 /**
@@ -89,7 +97,7 @@ bool Server::isNickInUse(const std::string& nick, const Client* requesting_clien
  *                 ; "[", "]", "\", "`", "_", "^", "{", "|", "}"
  */
 void	Server::nickCommand(Message& msg, Client& cli){
-	std::vector<std::string>	params = msg.getParameters();
+	const ParamList&	params = msg.getParameters();
 	std::string	usr_nick = cli.getNick().empty() ? "*" : cli.getNick();
 	// 1. should contain at least one parameter
 	if (params.size() == 0){
@@ -97,9 +105,9 @@ void	Server::nickCommand(Message& msg, Client& cli){
 		Logger::log(Logger::WARNING, "no nickname is given");
 		return;
 	}
-	const std::string& nick = params.at(0);
-	// 2. nickname length checking (between 1~9 characters)
-	if (nick.size() > 20 || nick.size() < 1){
+	const std::string	nick(params.at(0));
+	// 2. nickname length checking (between 1~NICK_MAX_LEN characters)
+	if (nick.size() > NICK_MAX_LEN || nick.size() < 1){
 		responseToClient(cli, erroneusNickName(usr_nick));
 		Logger::log(Logger::WARNING, "nickname is too long");
 		return;
@@ -126,21 +134,26 @@ void	Server::nickCommand(Message& msg, Client& cli){
 			return;
 		}
 	}
-	const std::string&	old_prefix = cli.getPrefix();
+	std::string			old_prefix = cli.getPrefix(); // setNick() rebuilds the prefix
+	std::string			old_key = foldNick(cli.getNick());
 	cli.setNick(nick);
 	if (cli.isRegistered() == false){ // first time registeration
 		attempRegisterClient(cli);
 	} else{ // reset nickname
-		responseToClient(cli, rplResetNick(old_prefix, nick));
-		Logger::log(Logger::INFO, "Send reset nick notification to userself");
-		// notice channels users who are joined the same channel with the user
-		for (const auto& [name, channel_ptr] : channels_){
-			if (channel_ptr->isUserInList(cli, USERTYPE::REGULAR) == true){
-				std::string	message = rplResetNick(old_prefix, nick);
-				channel_ptr->notifyChannelUsers(cli, message);
-				Logger::log(Logger::INFO, "Send reset nick notification to channel users");
-			}
+		// move the index entry, the old nick is free from now on
+		nicks_.erase(old_key);
+		nicks_[foldNick(nick)] = &cli;
+		for (Channel* channel : cli.getChannels()){
+			channel->invalidateNames();
 		}
+		// the same bytes go to the user and every channel, serialize them once
+		Payload	message = rplResetNick(old_prefix, nick);
+		responseToClient(cli, message);
+		Logger::log(Logger::INFO, "Send reset nick notification to userself");
+		// notice channels users who are joined the same channel with the user,
+		// once each however many channels they share
+		notifyNeighbors(cli, message);
+		Logger::log(Logger::INFO, "Send reset nick notification to channel users");
 	}
 }
 
@@ -155,15 +168,15 @@ void	Server::nickCommand(Message& msg, Client& cli){
  *
  */
 void	Server::userCommand(Message& msg, Client& cli){
-	std::vector<std::string>	params = msg.getParameters();
+	const ParamList&	params = msg.getParameters();
 
 	if (params.size() < 3 || msg.getTrailing().empty()){
 		responseToClient(cli, needMoreParams("USER"));
 		Logger::log(Logger::WARNING, "Need more parameters");
 		return;
 	}
-	const std::string& username = params.at(0);
-	const std::string& realname = msg.getTrailing();
+	const std::string	username(params.at(0));
+	const std::string	realname(msg.getTrailing());
 
 	for (auto c : username){
 		if (!isalnum(static_cast<unsigned char>(c))
@@ -185,8 +198,8 @@ void	Server::userCommand(Message& msg, Client& cli){
 	}
 	cli.setUsername(username);
 	cli.setRealname(realname);
-	cli.setHostname(params.at(1));
-	cli.setServername(params.at(2));
+	cli.setHostname(hosts_.intern(params.at(1)));
+	cli.setServername(std::string(params.at(2)));
 	if (cli.isRegistered() == false){
 		attempRegisterClient(cli);
 	}
@@ -225,8 +238,8 @@ void Server::quitCommand(Message& msg, Client& cli){
  * @param cli  The client issuing the PART command.
  */
 void	Server::partCommand(Message& msg, Client& cli){
-	std::vector<std::string> channel_list = msg.getChannels();
-	std::vector<std::string> target_list = msg.getUsers();
+	const ParamList& channel_list = msg.getChannels();
+	const ParamList& target_list = msg.getUsers();
 
 	if (channel_list.size() == 0 || (target_list.size() > 0)){
 		responseToClient(cli, needMoreParams("PART"));
@@ -236,9 +249,7 @@ void	Server::partCommand(Message& msg, Client& cli){
 		return;
 	}
 
-	bool	is_operator;
 	for(const auto& channel_name : channel_list){
-		is_operator = false;
 		std::shared_ptr<Channel> channel_ptr = getChannelByName(channel_name);
 		if (!channel_ptr) {
 			responseToClient(cli, errNoSuchChannel(cli.getNick(), channel_name));
@@ -248,16 +259,13 @@ void	Server::partCommand(Message& msg, Client& cli){
 			responseToClient(cli, notOnChannel(cli.getNick(), channel_name));
 			continue;
 		}
-		if (channel_ptr->isChannelOperator(cli)){
-			is_operator = true;
-		}
-		std::string message = rplPart(cli.getPrefix(), channel_name, msg.getTrailing());
-		channel_ptr->notifyChannelUsers(cli, message);
+		Payload message = rplPart(cli.getPrefix(), channel_ptr->getName(), msg.getTrailing());
+		channel_ptr->notifyMembershipChange(cli, message);
 		responseToClient(cli, message);
 		channel_ptr->removeUser(cli);
-		Logger::log(Logger::INFO, "A member left channel:" + channel_name);
+		Logger::log(Logger::INFO, "A member left channel:" + std::string(channel_name));
 		if (channel_ptr->isEmptyChannel()) { // channel is empty, remove it
-			removeChannel(channel_name);
+			removeChannel(*channel_ptr);
 		}
 	}
 }
@@ -295,8 +303,8 @@ void	Server::partCommand(Message& msg, Client& cli){
  * @param user  The client issuing the KICK command.
  */
 void	Server::kickUser(Message& msg, Client& user){
-	std::vector<std::string> channel_list = msg.getChannels();
-	std::vector<std::string> target_list = msg.getUsers();
+	const ParamList& channel_list = msg.getChannels();
+	const ParamList& target_list = msg.getUsers();
 	size_t	n_channel = channel_list.size();
 	size_t 	n_target = target_list.size();
 
@@ -323,7 +331,7 @@ void	Server::kickUser(Message& msg, Client& user){
 			return ;
 		}
 		for(const auto& target_nick : target_list){
-			std::shared_ptr<Client> target_ptr = getUserByNick(target_nick);
+			Client* target_ptr = getUserByNick(target_nick);
 			if (!target_ptr) {
 				responseToClient(user, errNoSuchNick(user.getNick(), target_nick));
 				continue ;
@@ -332,16 +340,16 @@ void	Server::kickUser(Message& msg, Client& user){
 				responseToClient(user, userNotInChannel(user.getNick(), target_nick, channel_list.at(0)));
 				continue;
 			}
-			if (target_nick == user.getNick()){
+			if (target_ptr == &user){
 				responseToClient(user, noticeToUser(user.getNick(), "You cannot kick yourself from a channel."));
 				continue;
 			}
 
-			std::string message = rplKick(user.getNick(), target_nick, channel_list.at(0), msg.getTrailing());
+			Payload message = rplKick(user.getNick(), target_nick, channel_ptr->getName(), msg.getTrailing());
     		channel_ptr->notifyChannelUsers(*getUserByNick(target_nick), message);
     		responseToClient(*getUserByNick(target_nick), message);
 
-    		Logger::log(Logger::INFO, "User " + target_nick + " was kicked from channel " + channel_list.at(0) + " by " + user.getNick());
+    		Logger::log(Logger::INFO, "User " + std::string(target_nick) + " was kicked from channel " + std::string(channel_list.at(0)) + " by " + user.getNick());
     		channel_ptr->removeUser(*getUserByNick(target_nick));
 		}
 	} else if (n_target == 1 && n_channel > 0){
@@ -359,7 +367,7 @@ void	Server::kickUser(Message& msg, Client& user){
 				responseToClient(user, ChanoPrivsNeeded(user.getNick(), channel_name));
 				continue;
 			}
-			std::shared_ptr<Client> target_ptr = getUserByNick(target_list.at(0));
+			Client* target_ptr = getUserByNick(target_list.at(0));
 			if (!target_ptr) {
 				responseToClient(user, errNoSuchNick(user.getNick(), target_list.at(0)));
 				continue ;
@@ -368,22 +376,22 @@ void	Server::kickUser(Message& msg, Client& user){
 				responseToClient(user, userNotInChannel(user.getNick(), target_list.at(0), channel_name));
 				continue;
 			}
-			if (target_list.at(0) == user.getNick()){
+			if (target_ptr == &user){
 				responseToClient(user, canNotSendToChan(user.getNick(), "You cannot kick yourself from a channel."));
 				continue;
 			}
 
-			std::string message = rplKick(user.getNick(), target_list.at(0), channel_name, msg.getTrailing());
+			Payload message = rplKick(user.getNick(), target_list.at(0), channel_ptr->getName(), msg.getTrailing());
 			channel_ptr->notifyChannelUsers(*getUserByNick(target_list.at(0)), message);
 			responseToClient(*getUserByNick(target_list.at(0)), message);
 
-			Logger::log(Logger::INFO, "User " + target_list.at(0) + " was kicked from channel " + channel_name + " by " + user.getNick());
+			Logger::log(Logger::INFO, "User " + std::string(target_list.at(0)) + " was kicked from channel " + std::string(channel_name) + " by " + user.getNick());
     		channel_ptr->removeUser(*getUserByNick(target_list.at(0)));
 		}
 	} else if (n_channel == n_target) {
 		for (size_t i = 0; i < n_channel; ++i) {
-			const std::string& channel_name = channel_list[i];
-			const std::string& target_nick = target_list[i];
+			const std::string	channel_name(channel_list[i]);
+			const std::string	target_nick(target_list[i]);
 			std::shared_ptr<Channel> channel_ptr = getChannelByName(channel_name);
 
 			if (!channel_ptr) {
@@ -398,7 +406,7 @@ void	Server::kickUser(Message& msg, Client& user){
 				responseToClient(user, ChanoPrivsNeeded(user.getNick(), channel_name));
 				continue;
 			}
-			std::shared_ptr<Client> target_ptr = getUserByNick(target_nick);
+			Client* target_ptr = getUserByNick(target_nick);
 			if (!target_ptr){
 				responseToClient(user, errNoSuchNick(user.getNick(), target_list.at(0)));
 				continue;
@@ -407,12 +415,12 @@ void	Server::kickUser(Message& msg, Client& user){
 				responseToClient(user, userNotInChannel(user.getNick(), target_nick, channel_name));
 				continue;
 			}
-			if (target_nick == user.getNick()){
+			if (target_ptr == &user){
 				responseToClient(user, canNotSendToChan(user.getNick(), "You cannot kick yourself from a channel."));
 				continue;
 			}
 
-			std::string message = rplKick(user.getNick(), target_nick, channel_name, msg.getTrailing());
+			Payload message = rplKick(user.getNick(), target_nick, channel_ptr->getName(), msg.getTrailing());
 			channel_ptr->notifyChannelUsers(*target_ptr, message);
 			responseToClient(*target_ptr, message);
 
@@ -451,8 +459,8 @@ void	Server::kickUser(Message& msg, Client& user){
  * @param user  The client issuing the INVITE command.
  */
 void    Server::inviteUser(Message& msg, Client& user){
-	std::vector<std::string> channel_list = msg.getChannels();
-	std::vector<std::string> target_list = msg.getUsers();
+	const ParamList& channel_list = msg.getChannels();
+	const ParamList& target_list = msg.getUsers();
 	size_t	n_channel = channel_list.size();
 	size_t 	n_target = target_list.size();
 
@@ -479,7 +487,7 @@ void    Server::inviteUser(Message& msg, Client& user){
 			return ;
 		}
 		for(const auto& target_nick : target_list){
-			std::shared_ptr<Client> target_ptr = getUserByNick(target_nick);
+			Client* target_ptr = getUserByNick(target_nick);
 			if (!target_ptr) {
 				responseToClient(user, errNoSuchNick(user.getNick(), target_nick));
 				continue ;
@@ -488,9 +496,9 @@ void    Server::inviteUser(Message& msg, Client& user){
 				responseToClient(user, userOnChannel(user.getNick(), target_nick, channel_list.at(0)));
 				continue;
 			}
-			channel_ptr->insertUser(getUserByNick(target_nick), USERTYPE::INVITE);
-			responseToClient(user, Inviting(user.getNick(), channel_list.at(0), target_nick));
-			std::string inviteMessage = ":" + user.getNick() + " INVITE " + target_nick + " " + channel_list.at(0) + "\r\n";
+			channel_ptr->insertUser(*target_ptr, USERTYPE::INVITE);
+			responseToClient(user, Inviting(user.getNick(), channel_ptr->getName(), target_nick));
+			std::string inviteMessage = ":" + user.getNick() + " INVITE " + std::string(target_nick) + " " + channel_ptr->getName() + "\r\n";
     		responseToClient(*getUserByNick(target_nick), inviteMessage);
 		}
 	}  else if (n_target == 1 && n_channel > 0){
@@ -508,14 +516,14 @@ void    Server::inviteUser(Message& msg, Client& user){
 				responseToClient(user, ChanoPrivsNeeded(user.getNick(), channel_name));
 				continue;
 			}
-			std::shared_ptr<Client> target_ptr = getUserByNick(target_list.at(0));
+			Client* target_ptr = getUserByNick(target_list.at(0));
 			if (!target_ptr) {
 				responseToClient(user, errNoSuchNick(user.getNick(), target_list.at(0)));
 				return ;
 			}
-			channel_ptr->insertUser(target_ptr, USERTYPE::INVITE);
-			responseToClient(user, Inviting(user.getNick(), channel_name, target_ptr->getNick()));
-			std::string inviteMessage = ":" + user.getNick() + " INVITE " + target_ptr->getNick() + " " + channel_name + "\r\n";
+			channel_ptr->insertUser(*target_ptr, USERTYPE::INVITE);
+			responseToClient(user, Inviting(user.getNick(), channel_ptr->getName(), target_ptr->getNick()));
+			std::string inviteMessage = ":" + user.getNick() + " INVITE " + target_ptr->getNick() + " " + channel_ptr->getName() + "\r\n";
     		responseToClient(*getUserByNick(target_ptr->getNick()), inviteMessage);
 		}
 	} else {
@@ -549,8 +557,8 @@ void    Server::inviteUser(Message& msg, Client& user){
  * @param user  The client issuing the TOPIC command.
  */
 void	Server::topic(Message& msg, Client& user){
-	std::vector<std::string> channel_list = msg.getChannels();
-	std::vector<std::string> target_list = msg.getUsers();
+	const ParamList& channel_list = msg.getChannels();
+	const ParamList& target_list = msg.getUsers();
 	size_t	n_channel = channel_list.size();
 
 	if (channel_list.size() == 0 || target_list.size() != 0){
@@ -575,9 +583,9 @@ void	Server::topic(Message& msg, Client& user){
 	// No trailing parameter present AND there was no explicit ':' → just display topic (or no topic)
 	if (msg.getTrailing().empty() && msg.getTrailingEmpty() == false){
 		if (channel_ptr->getTopic().empty())
-			responseToClient(user, NoTopic(user.getNick(), channel_list.at(0)));
+			responseToClient(user, NoTopic(user.getNick(), channel_ptr->getName()));
 		else
-			responseToClient(user, Topic(user.getNick(), channel_list.at(0), channel_ptr->getTopic()));
+			responseToClient(user, Topic(user.getNick(), channel_ptr->getName(), channel_ptr->getTopic()));
 		return ;
 	}
 	if (channel_ptr->getTopicMode() && !channel_ptr->isChannelOperator(user)){
@@ -587,20 +595,20 @@ void	Server::topic(Message& msg, Client& user){
 
     if (msg.getTrailingEmpty() == true) {
 		channel_ptr->addNewTopic("");
-    	Logger::log(Logger::INFO, "User " + user.getNick() + " cleared topic in channel " + channel_list.at(0));
+    	Logger::log(Logger::INFO, "User " + user.getNick() + " cleared topic in channel " + std::string(channel_list.at(0)));
 
-   		std::string message = Topic(user.getNick(), channel_list.at(0), "");
+   		Payload message = Topic(user.getNick(), channel_ptr->getName(), "");
     	channel_ptr->notifyChannelUsers(user, message);
     	responseToClient(user, message);
         return;
     }
 
-	channel_ptr->addNewTopic(msg.getTrailing());
-	std::string message = Topic(user.getNick(), channel_list.at(0), msg.getTrailing());
+	channel_ptr->addNewTopic(std::string(msg.getTrailing()));
+	Payload message = Topic(user.getNick(), channel_ptr->getName(), msg.getTrailing());
 	channel_ptr->notifyChannelUsers(user, message);
 	responseToClient(user, message);
 
-    Logger::log(Logger::INFO, "User " + user.getNick() + " set new topic in channel " + channel_list.at(0) + ": " + msg.getTrailing());
+    Logger::log(Logger::INFO, "User " + user.getNick() + " set new topic in channel " + std::string(channel_list.at(0)) + ": " + std::string(msg.getTrailing()));
 }
 
 /**
@@ -613,7 +621,7 @@ void	Server::topic(Message& msg, Client& user){
  *   2. Supports multiple mode flags in a single command (e.g., "+itlk key 10").
  *   3. Parameters must be provided in the correct order and quantity as required by the flags.
  *      - Flags that require arguments: 'k' (password), 'l' (user limit), 'o' (operator toggle).
- *      - Flags without arguments: 'i' (invite-only), 't' (topic restrictions).
+ *      - Flags without arguments: 'i' (invite-only), 't' (topic restrictions), 'u' (auditorium).
  *
  * Function behavior:
  *   - If no flags are specified, the current channel modes are returned using RPL_CHANNELMODEIS (324).
@@ -627,6 +635,8 @@ void	Server::topic(Message& msg, Client& user){
  * 	 | `+k <key>`   | `-k`         | Set/unset a password required to join the channel |
  * 	 | `+o <nick>`  | `-o <nick>`  | Grant/revoke operator status to a user            |
  * 	 | `+l <limit>` | `-l`         | Set/unset a maximum user limit in the channel     |
+ * 	 | `+u`         | `-u`         | Show joins, parts and quits of regular members to |
+ * 	 |              |              | the operators only (auditorium)                   |
  *
  *   - Notifies all users in the channel of the mode changes.
  *   - Returns error replies for invalid flags, missing parameters, or permission issues.
@@ -640,12 +650,12 @@ void	Server::topic(Message& msg, Client& user){
 //  MODE #a
 void	Server::mode(Message& msg, Client& user){
 
-	std::vector<std::string> params_list = msg.getParameters();
-	std::vector<std::string> target_list = msg.getUsers();
-	std::vector<std::string> channel_list = msg.getChannels();
+	const ParamList& params_list = msg.getParameters();
+	const ParamList& target_list = msg.getUsers();
+	const ParamList& channel_list = msg.getChannels();
 
 	if (!target_list.empty() && params_list.at(0) == target_list.at(0)){
-		if (user.getNick() != target_list.at(0)){
+		if (!CaseMap::equals(user.getNick(), target_list.at(0), config_.casemapping)){
 			responseToClient(user, usersDontMatch(user.getNick())); // ERR_USERSDONTMATCH
 			return;
 		}
@@ -653,7 +663,7 @@ void	Server::mode(Message& msg, Client& user){
 			responseToClient(user, rplUserModeIs(user.getNick(), user.getUserMode()));
 			return ;
 		}
-		const std::string mode = params_list.at(1);
+		const std::string mode(params_list.at(1));
 		// Validate: must start with + or - followed by valid mode chars
 		std::regex mode_regex("^([+-][iworO]*)+$");
 		if (!std::regex_match(mode, mode_regex)){
@@ -674,7 +684,7 @@ void	Server::mode(Message& msg, Client& user){
 		return;
 	}
 
-	std::string	channel_name = channel_list.at(0);//params_list.at(0);
+	std::string	channel_name(channel_list.at(0));//params_list.at(0);
 	std::shared_ptr<Channel> channel_ptr = getChannelByName(channel_name);
 	if (!channel_ptr){
         responseToClient(user, errNoSuchChannel(user.getNick(), channel_name));
@@ -684,6 +694,7 @@ void	Server::mode(Message& msg, Client& user){
         responseToClient(user, notOnChannel(user.getNick(), channel_name));
         return;
     }
+	channel_name = channel_ptr->getName();
 
 	std::string	mode_flags = "";
 	if (params_list.size() > 1)
@@ -704,6 +715,7 @@ void	Server::mode(Message& msg, Client& user){
         if (channel_ptr->getTopicMode()) status += "t";
         if (channel_ptr->getPasswdMode()) status += "k";
         if (channel_ptr->getLimitMode()) status += "l";
+        if (channel_ptr->getAuditoriumMode()) status += "u";
 		// Prepend '+' only if at least one mode is active
     	if (!status.empty())
         	status = "+" + status;
@@ -737,6 +749,10 @@ void	Server::mode(Message& msg, Client& user){
 			adding ? channel_ptr->setTopicRestrictions() : channel_ptr->unsetTopicRestrictions();
 			update_modes += (adding ? "+t" : "-t");
 		}
+		else if (c == 'u'){
+			adding ? channel_ptr->setAuditorium() : channel_ptr->unsetAuditorium();
+			update_modes += (adding ? "+u" : "-u");
+		}
 		else if (c == 'k'){
 			if (adding){
 				if (arg_index >= args.size()){
@@ -779,7 +795,7 @@ void	Server::mode(Message& msg, Client& user){
 				return;
 			}
 			std::string nick = args[arg_index++];
-			std::shared_ptr<Client> target_ptr = getUserByNick(nick);
+			Client* target_ptr = getUserByNick(nick);
 			if (!target_ptr){
 				responseToClient(user, errNoSuchNick(user.getNick(), nick));
 				continue ;
@@ -809,7 +825,7 @@ void	Server::mode(Message& msg, Client& user){
 	for (const std::string& arg : params){
 		params_str += " " + arg;
 	}
-	std::string message = rplMode(user.getPrefix(), channel_name, update_modes, params_str);
+	Payload message = rplMode(user.getPrefix(), channel_name, update_modes, params_str);
 	channel_ptr->notifyChannelUsers(user, message);
 	responseToClient(user, message);
 }
@@ -841,8 +857,8 @@ void	Server::mode(Message& msg, Client& user){
 // checking if channel reaches the server/user limit logic
 void	Server::joinCommand(Message& msg, Client& cli){
 	const std::string&	nick = cli.getNick();
-	std::vector<std::string>	channels = msg.getChannels();
-	std::vector<std::string>	passwds = msg.getPasswords();
+	const ParamList&	channels = msg.getChannels();
+	const ParamList&	passwds = msg.getPasswords();
 	size_t	index = 0;
 
 	// checking if the arguments number is valid
@@ -876,14 +892,10 @@ void	Server::joinCommand(Message& msg, Client& cli){
 				Logger::log(Logger::WARNING, "the user has reached its maximum number of allowed channels");
 				return;
 			}
-			//channels_[chan_name] = std::make_shared<Channel>(chan_name, cli);
 			// Create the new channel and add the user as operator
-			channel = std::make_shared<Channel>(chan_name, cli);
-			channels_[chan_name] = channel;
-			n_channel_++;
-			cli.increaseUserNchannel();
+			channel = addChannel(std::string(chan_name), cli);
 			if (passwds_index < passwds.size()){
-				const std::string& passwd = passwds[passwds_index++];
+				const std::string	passwd(passwds[passwds_index++]);
 				if (!isValidModePassword(passwd)){
 					responseToClient(cli, InvalidModeParamErr(nick, chan_name, 'k', passwd, "Invalid channel key"));
 					Logger::log(Logger::WARNING, "Invalid channel key");
@@ -893,7 +905,7 @@ void	Server::joinCommand(Message& msg, Client& cli){
 				channel->setPassword();
 			}
 			responseToClient(cli, rplJoin(cli.getPrefix(), chan_name));
-			std::string	message = chan_name + " has been created. Now server has " + std::to_string(n_channel_) + " channels";
+			std::string	message = std::string(chan_name) + " has been created. Now server has " + std::to_string(n_channel_) + " channels";
 			Logger::log(Logger::INFO, message);
 
 
@@ -901,70 +913,87 @@ void	Server::joinCommand(Message& msg, Client& cli){
 			// std::cout << "call from joincommand\n";// for testing only
 			// printChannels(); // for testing only
 		} else {
+			// the replies name the channel the way its creator spelled it
 			// checking if the user is in the channel already. If yes, then return without
 			// doing anything
 			if (channel->isUserInList(cli, USERTYPE::REGULAR) == true){
 				// :server 443 hele #test3 :is already on channel
-				responseToClient(cli, userOnChannel(nick, "", chan_name));
+				responseToClient(cli, userOnChannel(nick, "", channel->getName()));
 				Logger::log(Logger::WARNING, "User joined the channel already");
 				continue;
 			}
 			// checking if the channel is full, only if flag user_limit_ is true
 			if (channel->getLimitMode() && channel->isFullChannel() == true){
-				responseToClient(cli, channelIsFull(nick, chan_name));
+				responseToClient(cli, channelIsFull(nick, channel->getName()));
 				Logger::log(Logger::WARNING, "Channel is full");
 				continue;
 			}
 			// If the channel needs a password, but the client doesn't provide it
 			if (channel->getPasswdMode() == true){
 				if (passwds.size() == 0){
-					responseToClient(cli, badChannelKey(nick,chan_name));
+					responseToClient(cli, badChannelKey(nick,channel->getName()));
 					Logger::log(Logger::WARNING, "No channel key is provided");
 					continue;
 				}
 				if (channel->getPassword() != passwds.at(index++)){
-					responseToClient(cli, badChannelKey(nick,chan_name));
+					responseToClient(cli, badChannelKey(nick,channel->getName()));
 					Logger::log(Logger::WARNING, "Channel key doesn't mattach");
 					continue;
 				}
 			}
 			// If the channel is invite_only but the client is not on the invitee list
 			if (channel->getInviteMode() == true && channel->isUserInList(cli, USERTYPE::INVITE) == false){
-				responseToClient(cli, inviteOnlyChan(nick, chan_name));
+				responseToClient(cli, inviteOnlyChan(nick, channel->getName()));
 				Logger::log(Logger::WARNING, "This is invite only channel");
 				continue ;
 			}
 			channel->addNewUser(cli);
-			cli.increaseUserNchannel(); // increase the channel number that the user joined
-			std::string	message = rplJoin(cli.getPrefix(), chan_name);
-			channel->notifyChannelUsers(cli, message);
+			Payload	message = rplJoin(cli.getPrefix(), channel->getName());
+			channel->notifyMembershipChange(cli, message);
 			responseToClient(cli, message);
 			Logger::log(Logger::INFO, "Notify the channel user, new member joined");
 		}
 		// if the channel topic is set, send TOPIC to the joiner
 		if (channel->getTopic().empty() == false){
-			responseToClient(cli, Topic(nick, chan_name, channel->getTopic()));
+			responseToClient(cli, Topic(nick, channel->getName(), channel->getTopic()));
 			Logger::log(Logger::INFO, "show the channel topic");
 		}
 
-		//Handle sending 353 353 RPL_NAMREPLY and 366 RPL_ENDOFNAMES
-		// Add "@" prefix to operator names
-		std::string	names;
-		for (const auto& usr_prt : channel->getChannelUsers()){
-			if (channel->isChannelOperator(*usr_prt) == true){
-				names += '@';
-			}
-			names += usr_prt->getNick() + " ";
+		// draft/no-implicit-names: the client asks for NAMES itself if it wants them
+		if (!cli.hasCap(Client::CAP_NO_IMPLICIT_NAMES)){
+			sendNames(cli, *channel);
 		}
-		if (names.empty() == false){
-			names.pop_back();
+	}
+}
+
+/**
+ * @brief Send 353 RPL_NAMREPLY and 366 RPL_ENDOFNAMES. The channel keeps the
+ * name lists split to the line limit, a join into a big channel doesn't walk
+ * its members again. Only the operators of a +u channel see all its members,
+ * a regular member sees the operators and itself.
+ */
+void	Server::sendNames(Client& cli, Channel& channel){
+	bool	operators_only = channel.isHiddenMember(cli); // +u
+	const std::vector<std::string>&	lists = channel.getNames(operators_only);
+	// the own name goes with the last list when it fits, on a line of its own otherwise
+	bool	add_self = operators_only && channel.isChannelUser(cli);
+
+	for (size_t i = 0; i < lists.size(); i++){
+		if (add_self && i + 1 == lists.size()
+			&& lists[i].size() + 1 + cli.getNick().size() <= channel.namesBudget()){
+			responseToClient(cli, rplNamReply(cli.getNick(), channel.getName(), lists[i] + " " + cli.getNick()));
+			add_self = false;
+		} else{
+			responseToClient(cli, rplNamReply(cli.getNick(), channel.getName(), lists[i]));
 		}
-		responseToClient(cli, rplNamReply(nick, chan_name, names));
-		responseToClient(cli, rplEndOfNames(nick, chan_name));
 	}
+	if (add_self){
+		responseToClient(cli, rplNamReply(cli.getNick(), channel.getName(), cli.getNick()));
+	}
+	responseToClient(cli, rplEndOfNames(cli.getNick(), channel.getName()));
 }
 
-bool	Server::isChannelValid(const std::string& channel_name){
+bool	Server::isChannelValid(std::string_view channel_name){
 	char	first_char = channel_name[0];
 	if (std::string(SUPPORTCHANNELPREFIX).find(first_char) == std::string::npos){ // doesn't find
 		return false;
@@ -987,13 +1016,8 @@ bool	Server::isChannelValid(const std::string& channel_name){
 }
 
 
-bool	Server::isExistedChannel(const std::string& channel_name){
-	for (const auto& [name, channelPtr] : channels_){
-		if (name == channel_name){
-			return true;
-		}
-	}
-	return false;
+bool	Server::isExistedChannel(std::string_view channel_name) const{
+	return getChannelByName(channel_name) != nullptr;
 }
 
 /**
@@ -1001,10 +1025,10 @@ bool	Server::isExistedChannel(const std::string& channel_name){
  * Can be used to message multiple users and/or channels at the same time
  */
 void Server::privmsgCommand(Message& msg, Client& cli){
-    std::vector<std::string> channels = msg.getChannels();
-    std::vector<std::string> users = msg.getUsers();
-	std::vector<std::string> params_list = msg.getParameters();
-	const std::string& message = msg.getTrailing();
+    const ParamList& channels = msg.getChannels();
+    const ParamList& users = msg.getUsers();
+	const ParamList& params_list = msg.getParameters();
+	const std::string	message(msg.getTrailing());
 
     if (channels.empty() && users.empty()){
 		responseToClient(cli, needMoreParams("PRIVMSG"));
@@ -1034,11 +1058,12 @@ void Server::privmsgCommand(Message& msg, Client& cli){
 			Logger::log(Logger::ERROR, "User isn't on the channel");
             continue;
         }
-		channel_ptr->notifyChannelUsers(cli, rplPrivMsg(cli.getNick(), channel_name, message));
+		channel_ptr->notifyChannelUsers(cli, rplPrivMsg(cli.getNick(), channel_ptr->getName(), message),
+			TRAFFIC::DROPPABLE);
 		Logger::log(Logger::INFO, "send message to channel users");
     }
     for (const auto& target_nick : users){
-        std::shared_ptr<Client> target_client = getUserByNick(target_nick);
+        Client* target_client = getUserByNick(target_nick);
         if (!target_client){
             responseToClient(cli, errNoSuchNick(cli.getNick(), target_nick));
 			Logger::log(Logger::ERROR, "no such nick");
@@ -1060,26 +1085,63 @@ std::string Server::trim(const std::string& str){
     return str.substr(start, end - start);
 }
 
+/**
+ * @brief The bit of a capability of SUPPORTCAPS, 0 when it isn't supported.
+ */
+static uint8_t	capabilityBit(std::string_view name){
+	if (name == "multi-prefix"){
+		return Client::CAP_MULTI_PREFIX;
+	}
+	if (name == "draft/no-implicit-names"){
+		return Client::CAP_NO_IMPLICIT_NAMES;
+	}
+	return 0;
+}
+
 /**
  * @brief starts "Client Capability Communication" between the client and the server.
  * This is done automatically on startup by irssi, so we only handle the responses irssi
  * expects to hear in order to set up a successful connection.
+ *
+ * A REQ is all or nothing: if one of the capabilities is unknown the whole list
+ * is NAKed and nothing changes. A capability prefixed with '-' is disabled.
  */
 void Server::capCommand(Message& msg, Client& cli){
-	std::vector<std::string> parameters = msg.getParameters();
-	std::string subcmd = parameters.empty() ? "" : parameters[0];
+	const ParamList& parameters = msg.getParameters();
+	std::string subcmd(parameters.empty() ? std::string_view() : parameters[0]);
 
 	if (subcmd == "LS"){
-		std::string response = "CAP * LS :multi-prefix\r\n";
-		responseToClient(cli, response);
+		responseToClient(cli, rplCap("LS", SUPPORTCAPS));
 	} else if (subcmd == "REQ"){
-		std::string requested_caps = trim(msg.getTrailing());
-		if (!requested_caps.empty()){
-			std::string response = "CAP * ACK :" + requested_caps + "\r\n";
-			responseToClient(cli, response);
-		} else{
+		// "CAP REQ :a b" or, for a single capability, "CAP REQ a"
+		std::string requested_caps = trim(std::string(msg.getTrailing()));
+		if (requested_caps.empty() && parameters.size() > 1){
+			requested_caps = std::string(parameters[1]);
+		}
+		if (requested_caps.empty()){
 			Logger::log(Logger::ERROR, "CAP REQ missing capability list");
+			return;
+		}
+		uint8_t				caps = cli.getCaps();
+		std::string_view	list(requested_caps);
+		while (!list.empty()){
+			size_t				end = list.find(' ');
+			std::string_view	name = list.substr(0, end);
+			list = end == std::string_view::npos ? std::string_view() : list.substr(end + 1);
+			if (name.empty()){
+				continue;
+			}
+			bool	disable = name[0] == '-';
+			uint8_t	bit = capabilityBit(disable ? name.substr(1) : name);
+			if (bit == 0){
+				responseToClient(cli, rplCap("NAK", requested_caps));
+				Logger::log(Logger::WARNING, "CAP REQ of an unsupported capability: " + std::string(name));
+				return;
+			}
+			caps = disable ? (caps & ~bit) : (caps | bit);
 		}
+		cli.setCaps(caps);
+		responseToClient(cli, rplCap("ACK", requested_caps));
 	} else if (subcmd == "END"){
 		// No response needed — just move on to registration
 	} else{
@@ -1103,6 +1165,18 @@ bool Server::isValidModePassword(const std::string& key){
     return true;
 }
 
+/**
+ * @brief Whether oper is an operator of a channel target is in.
+ */
+bool Server::isOperatorOf(Client& oper, Client& target){
+	for (Channel* channel : oper.getChannels()){
+		if (channel->isChannelOperator(oper) && channel->isChannelUser(target)){
+			return true;
+		}
+	}
+	return false;
+}
+
 bool Server::isPositiveInteger(const std::string& s){
     return !s.empty() && std::all_of(s.begin(), s.end(), ::isdigit);
 }
@@ -1116,22 +1190,31 @@ void Server::pingCommand(Message& msg, Client& cli){
 		responseToClient(cli, noOrigin(cli.getNick()));
 		return;
 	}
-	const std::string& origin = msg.getParameters().at(0);
+	const std::string	origin(msg.getParameters().at(0));
 	responseToClient(cli, "PONG :" + origin + "\r\n");
 }
 
+/**
+ * @brief Answer to the server's PING. Nothing to do here: every line counts as
+ * a sign of life (see Client::touch()), the client's timer sees it.
+ */
+void Server::pongCommand(Message& msg, Client& cli){
+	(void)msg;
+	(void)cli;
+}
+
 /**
  * @brief Used by irssi when multiple users try to connect with the same information.
  * Confirms whether the user information is the exact same or not
  */
 void Server::whoisCommand(Message& msg, Client& cli){
-	std::vector<std::string> params = msg.getParameters();
+	const ParamList& params = msg.getParameters();
 	if (params.empty()){
 		responseToClient(cli, nonNickNameGiven(cli.getNick()));
 		return;
 	}
-	std::string targetNick = params[0];
-	std::shared_ptr<Client> target = getUserByNick(targetNick);
+	std::string targetNick(params[0]);
+	Client* target = getUserByNick(targetNick);
 	if (!target){
 		responseToClient(cli, errNoSuchNick(cli.getNick(), targetNick));
 		responseToClient(cli, rplEndOfWhois(cli.getNick(), targetNick));
@@ -1139,11 +1222,15 @@ void Server::whoisCommand(Message& msg, Client& cli){
 	}
 	std::string channels = getChannelsOfUser(*target);
 	if (!channels.empty()){
-		std::string r319 = rplWhoIsChannels(cli.getNick(), target->getNick(), channels);
+		Payload r319 = rplWhoIsChannels(cli.getNick(), target->getNick(), channels);
 		responseToClient(cli, r319);
 	}
 	responseToClient(cli, rplWhoIsServer(cli.getNick(), target->getNick()));
 	responseToClient(cli, rplWhoisUser(cli.getNick(), target->getNick(), target->getUsername(), target->getHostname(), target->getRealname()));
+	// how hard the target pushed against the flood control, for its channel operators
+	if (isOperatorOf(cli, *target)){
+		responseToClient(cli, rplWhoIsFloodPoints(cli.getNick(), target->getNick(), target->getFloodPoints()));
+	}
 	responseToClient(cli, rplEndOfWhois(cli.getNick(), targetNick));
 }
 
@@ -1154,22 +1241,48 @@ void Server::whoisCommand(Message& msg, Client& cli){
  * functionalities were not required to be supported in this project
  */
 void Server::whoCommand(Message& msg, Client& cli){
-    std::vector<std::string> params = msg.getParameters();
+    const ParamList& params = msg.getParameters();
     if (params.empty()){
         responseToClient(cli, needMoreParams("WHO"));
         return;
     }
-    std::string target = params[0];
+    std::string target(params[0]);
     std::shared_ptr<Channel> channel = getChannelByName(target);
     if (!channel){
         responseToClient(cli, errNoSuchChannel(cli.getNick(), target));
         return;
     }
-    const std::unordered_set<Client*>& users = channel->getChannelUsers();
-    for (const auto& user : users){
+    // in a +u channel a regular member sees the operators and itself, like NAMES
+    bool operators_only = channel->isHiddenMember(cli);
+    for (const auto& member : channel->getChannelUsers()){
+        if (operators_only && !(member.modes & ChannelMember::OPERATOR) && member.client != cli.getHandle())
+            continue;
+        const Client* user = getClient(member.client);
+        if (!user) continue;
         std::string status = "H";
-        if (channel->isChannelOperator(*user)) status += "@";
+        if (member.modes & ChannelMember::OPERATOR) status += "@";
         responseToClient(cli, rplWhoReply(cli.getNick(), channel->getName(), user->getUsername(), user->getHostname(), user->getNick(), status, user->getRealname()));
     }
-    responseToClient(cli, rplEndOfWho(cli.getNick(), target));
+    responseToClient(cli, rplEndOfWho(cli.getNick(), channel->getName()));
+}
+
+/**
+ * @brief NAMES <channel>{,<channel>}: the members of each channel, the way JOIN
+ * sends them. A client that negotiated draft/no-implicit-names uses it to get
+ * them when it wants them. Without a channel only the end of the list is sent.
+ */
+void Server::namesCommand(Message& msg, Client& cli){
+	const ParamList& channels = msg.getChannels();
+	if (channels.empty()){
+		responseToClient(cli, rplEndOfNames(cli.getNick(), "*"));
+		return;
+	}
+	for (std::string_view name : channels){
+		std::shared_ptr<Channel> channel = getChannelByName(name);
+		if (channel){
+			sendNames(cli, *channel);
+		} else{
+			responseToClient(cli, rplEndOfNames(cli.getNick(), name));
+		}
+	}
 }
@@ -0,0 +1,196 @@
+#include "Config.hpp"
+#include "SendQueue.hpp"
+#include <cctype>
+
+ServerConfig::ServerConfig() : flush_policy(FLUSHPOLICY::END_OF_TICK),
+flush_delay_us(DEFAULT_FLUSH_DELAY_US), workers(1),
+backend(BACKENDTYPE::EPOLL), tick_bytes(DEFAULT_TICK_BYTES),
+tick_commands(DEFAULT_TICK_COMMANDS), register_timeout(DEFAULT_REGISTER_TIMEOUT),
+ping_interval(DEFAULT_PING_INTERVAL), ping_timeout(DEFAULT_PING_TIMEOUT),
+idle_timeout(0), sendq_high(DEFAULT_SENDQ_HIGH), sendq_low(DEFAULT_SENDQ_LOW),
+sendq_policy(SENDQPOLICY::DISCONNECT), flood_rate(DEFAULT_FLOOD_RATE), flood_burst(DEFAULT_FLOOD_BURST),
+casemapping(CASEMAPPING::RFC1459), log_overflow(LOGPOLICY::DROP){
+}
+
+static int	parseNonNegative(const std::string& option, const std::string& value){
+	if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos
+		|| value.size() > 9){
+		throw std::invalid_argument("Error: " + option + " expects a non-negative number");
+	}
+	return std::stoi(value);
+}
+
+/**
+ * @brief Parse the options following <port> <password>.
+ *
+ * Supported options:
+ *   --flush <immediate|tick|cork>   when queued replies are written
+ *   --flush-delay-us <n>            upper bound of the TCP_CORK delay
+ *   --workers <n>                   number of reactor threads
+ *   --backend <epoll|io_uring>      how the reactors wait for I/O
+ *   --tick-bytes <n>                per client byte budget of a loop iteration
+ *   --tick-commands <n>             per client command budget of a loop iteration
+ *   --register-timeout <s>          time to register before being disconnected
+ *   --ping-interval <s>             silence before the server checks the client
+ *   --ping-timeout <s>              time to answer the server's PING
+ *   --idle-timeout <s>              time without commands before disconnecting (0 = off)
+ *   --sendq-high <bytes>            queued output that makes a client a slow consumer
+ *   --sendq-low <bytes>             queued output under which it has caught up
+ *   --sendq-policy <disconnect|drop|lag>  what to do with slow consumers
+ *   --flood-rate <n>                flood control tokens earned per second (0 = off)
+ *   --flood-burst <n>               flood control tokens a client can save up
+ *   --flood-cost <COMMAND>=<n>      tokens a command costs, can be repeated
+ *   --casemapping <rfc1459|ascii>   which nick and channel names are the same
+ *   --log-overflow <drop|block>     what logging does when the writer can't keep up
+ */
+ServerConfig	ServerConfig::fromArgs(int ac, char** av){
+	ServerConfig	config;
+
+	for (int i = 0; i < ac; i++){
+		std::string	option = av[i];
+		if (i + 1 >= ac){
+			throw std::invalid_argument("Error: missing value for " + option);
+		}
+		std::string	value = av[++i];
+		if (option == "--flush"){
+			if (value == "immediate"){
+				config.flush_policy = FLUSHPOLICY::IMMEDIATE;
+			} else if (value == "tick"){
+				config.flush_policy = FLUSHPOLICY::END_OF_TICK;
+			} else if (value == "cork"){
+				config.flush_policy = FLUSHPOLICY::CORK;
+			} else {
+				throw std::invalid_argument("Error: unknown flush policy '" + value + "'");
+			}
+		} else if (option == "--flush-delay-us"){
+			config.flush_delay_us = parseNonNegative(option, value);
+		} else if (option == "--workers"){
+			config.workers = parseNonNegative(option, value);
+			if (config.workers < 1 || config.workers > MAX_WORKERS){
+				throw std::invalid_argument("Error: --workers should be 1~" + std::to_string(MAX_WORKERS));
+			}
+		} else if (option == "--backend"){
+			if (value == "epoll"){
+				config.backend = BACKENDTYPE::EPOLL;
+			} else if (value == "io_uring"){
+				config.backend = BACKENDTYPE::IO_URING;
+			} else {
+				throw std::invalid_argument("Error: unknown backend '" + value + "'");
+			}
+		} else if (option == "--tick-bytes"){
+			config.tick_bytes = parseNonNegative(option, value);
+			if (config.tick_bytes < 512){
+				throw std::invalid_argument("Error: --tick-bytes should be at least 512");
+			}
+		} else if (option == "--tick-commands"){
+			config.tick_commands = parseNonNegative(option, value);
+			if (config.tick_commands < 1){
+				throw std::invalid_argument("Error: --tick-commands should be at least 1");
+			}
+		} else if (option == "--register-timeout" || option == "--ping-interval"
+			|| option == "--ping-timeout"){
+			int	seconds = parseNonNegative(option, value);
+			if (seconds < 1){
+				throw std::invalid_argument("Error: " + option + " should be at least 1");
+			}
+			if (option == "--register-timeout"){
+				config.register_timeout = seconds;
+			} else if (option == "--ping-interval"){
+				config.ping_interval = seconds;
+			} else {
+				config.ping_timeout = seconds;
+			}
+		} else if (option == "--idle-timeout"){
+			config.idle_timeout = parseNonNegative(option, value);
+		} else if (option == "--sendq-high"){
+			config.sendq_high = parseNonNegative(option, value);
+		} else if (option == "--sendq-low"){
+			config.sendq_low = parseNonNegative(option, value);
+		} else if (option == "--sendq-policy"){
+			if (value == "disconnect"){
+				config.sendq_policy = SENDQPOLICY::DISCONNECT;
+			} else if (value == "drop"){
+				config.sendq_policy = SENDQPOLICY::DROP;
+			} else if (value == "lag"){
+				config.sendq_policy = SENDQPOLICY::LAG;
+			} else {
+				throw std::invalid_argument("Error: unknown sendq policy '" + value + "'");
+			}
+		} else if (option == "--flood-rate"){
+			config.flood_rate = parseNonNegative(option, value);
+		} else if (option == "--flood-burst"){
+			config.flood_burst = parseNonNegative(option, value);
+			if (config.flood_burst < 1){
+				throw std::invalid_argument("Error: --flood-burst should be at least 1");
+			}
+		} else if (option == "--flood-cost"){
+			size_t	equal = value.find('=');
+			if (equal == std::string::npos || equal == 0){
+				throw std::invalid_argument("Error: --flood-cost expects <COMMAND>=<n>");
+			}
+			std::string	command = value.substr(0, equal);
+			for (auto& c : command){
+				c = std::toupper(static_cast<unsigned char>(c));
+			}
+			config.flood_costs.emplace_back(command, parseNonNegative(option, value.substr(equal + 1)));
+		} else if (option == "--casemapping"){
+			if (value == "rfc1459"){
+				config.casemapping = CASEMAPPING::RFC1459;
+			} else if (value == "ascii"){
+				config.casemapping = CASEMAPPING::ASCII;
+			} else {
+				throw std::invalid_argument("Error: unknown casemapping '" + value + "'");
+			}
+		} else if (option == "--log-overflow"){
+			if (value == "drop"){
+				config.log_overflow = LOGPOLICY::DROP;
+			} else if (value == "block"){
+				config.log_overflow = LOGPOLICY::BLOCK;
+			} else {
+				throw std::invalid_argument("Error: unknown log overflow policy '" + value + "'");
+			}
+		} else {
+			throw std::invalid_argument("Error: unknown option '" + option + "'");
+		}
+	}
+	if (config.sendq_low >= config.sendq_high || config.sendq_high > SENDQ_LIMIT){
+		throw std::invalid_argument("Error: expected --sendq-low < --sendq-high <= "
+			+ std::to_string(SENDQ_LIMIT));
+	}
+	return config;
+}
+
+std::string	ServerConfig::usage(){
+	return "Usage: ./ircserv <port> <password> [options]\n"
+		"Options:\n"
+		"  --flush <immediate|tick|cork>  when replies are written (default: tick)\n"
+		"  --flush-delay-us <n>           max TCP_CORK delay in microseconds (default: "
+		+ std::to_string(DEFAULT_FLUSH_DELAY_US) + ")\n"
+		"  --workers <n>                  event loop threads sharing the port (default: 1)\n"
+		"  --backend <epoll|io_uring>     event backend (default: epoll)\n"
+		"  --tick-bytes <n>               bytes a client gets read and parsed per loop iteration (default: "
+		+ std::to_string(DEFAULT_TICK_BYTES) + ")\n"
+		"  --tick-commands <n>            commands a client gets executed per loop iteration (default: "
+		+ std::to_string(DEFAULT_TICK_COMMANDS) + ")\n"
+		"  --register-timeout <s>         seconds to complete the registration (default: "
+		+ std::to_string(DEFAULT_REGISTER_TIMEOUT) + ")\n"
+		"  --ping-interval <s>            seconds of silence before the server sends PING (default: "
+		+ std::to_string(DEFAULT_PING_INTERVAL) + ")\n"
+		"  --ping-timeout <s>             seconds to answer the PING (default: "
+		+ std::to_string(DEFAULT_PING_TIMEOUT) + ")\n"
+		"  --idle-timeout <s>             seconds without commands before disconnecting (default: 0, off)\n"
+		"  --sendq-high <bytes>           queued output that makes a client a slow consumer (default: "
+		+ std::to_string(DEFAULT_SENDQ_HIGH) + ")\n"
+		"  --sendq-low <bytes>            queued output under which it has caught up (default: "
+		+ std::to_string(DEFAULT_SENDQ_LOW) + ")\n"
+		"  --sendq-policy <disconnect|drop|lag>  slow consumers are disconnected, miss channel\n"
+		"                                 messages or aren't read until they caught up (default: disconnect)\n"
+		"  --flood-rate <n>               flood control tokens a client earns per second, 0 = off (default: "
+		+ std::to_string(DEFAULT_FLOOD_RATE) + ")\n"
+		"  --flood-burst <n>              flood control tokens a client can save up (default: "
+		+ std::to_string(DEFAULT_FLOOD_BURST) + ")\n"
+		"  --flood-cost <COMMAND>=<n>     tokens a command costs, repeatable (e.g. JOIN=5)\n"
+		"  --casemapping <rfc1459|ascii>  nick and channel names differing only in these cases are the same (default: rfc1459)\n"
+		"  --log-overflow <drop|block>    when the log writer falls behind, lines are dropped (and counted)\n"
+		"                                 or logging waits for it (default: drop)\n";
+}
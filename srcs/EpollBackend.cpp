@@ -0,0 +1,159 @@
+#include "EpollBackend.hpp"
+#include "SendQueue.hpp"
+#include "Logger.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+
+EpollBackend::EpollBackend() : epoll_fd_(-1), listen_fd_(-1), wake_fd_(-1){
+	epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd_ == -1){
+		throw std::runtime_error("Error: epoll_create1 failed");
+	}
+	events_.resize(MAX_EVENTS);
+}
+
+EpollBackend::~EpollBackend(){
+	close(epoll_fd_);
+}
+
+const char*	EpollBackend::getName() const{
+	return "epoll";
+}
+
+void	EpollBackend::addListener(int fd){
+	struct epoll_event ev{};
+	// EPOLLIN for read events + EPOLLET for edge-triggered
+	ev.events = EPOLLIN | EPOLLET;
+	ev.data.fd = fd;
+	if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1){
+		throw std::runtime_error("Error: epoll_ctl ADD listen_fd failed");
+	}
+	listen_fd_ = fd;
+}
+
+void	EpollBackend::addWakeUpFd(int fd){
+	struct epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1){
+		throw std::runtime_error("Error: epoll_ctl ADD eventfd failed");
+	}
+	wake_fd_ = fd;
+}
+
+void	EpollBackend::addClient(int fd){
+	struct epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1){
+		throw std::runtime_error("epoll_ctl ADD client failed");
+	}
+}
+
+/**
+ * @brief Invalidate the pending events of this fd in the current batch, so the
+ * event loop doesn't touch the removed client. The buffer keeps its size,
+ * epoll_wait() relies on it.
+ */
+void	EpollBackend::removeClient(int fd){
+	for (auto& ev : events_){
+		if (ev.data.fd == fd){
+			ev.data.fd = -1;
+		}
+	}
+	epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+ssize_t	EpollBackend::send(int fd, SendQueue& queue){
+	return queue.flush(fd);
+}
+
+/**
+ * @brief EPOLLOUT is only armed while the client has unsent data, otherwise
+ * a level-triggered writable socket would wake epoll_wait() all the time. For
+ * the same reason EPOLLIN is dropped while the client isn't read.
+ */
+void	EpollBackend::watch(int fd, bool read, bool write){
+	struct epoll_event	ev{};
+	ev.events = 0;
+	if (read){
+		ev.events |= EPOLLIN;
+	}
+	if (write){
+		ev.events |= EPOLLOUT;
+	}
+	ev.data.fd = fd;
+	if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == -1){
+		Logger::log(Logger::WARNING, "epoll_ctl MOD client failed: " + std::string(strerror(errno)));
+	}
+}
+
+/**
+ * @brief The listening socket is edge-triggered, so accept everything pending.
+ */
+void	EpollBackend::acceptAll(IoHandler& handler){
+	while (true){
+		int client_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (client_fd < 0){
+			// No more pending connections
+			if (errno == EAGAIN || errno == EWOULDBLOCK){
+				return;
+			}
+			if (errno == EINTR || errno == ECONNABORTED){
+				continue;
+			}
+			// real errors
+			throw std::runtime_error("accept failed: " + std::string(strerror(errno)));
+		}
+		handler.onAccept(client_fd);
+	}
+}
+
+int	EpollBackend::wait(int timeout_ms, IoHandler& handler){
+	// the return value of epoll_wait():
+	// > 0  Number of file descriptors that are ready for the requested I/O.
+	// =0   Timeout occurred — no file descriptors were ready
+	// < 0  Error occurred — check errno for the specific error cause.
+	int nready = epoll_wait(epoll_fd_, events_.data(), events_.size(), timeout_ms);
+	if (nready < 0){
+		if (errno == EINTR){
+			return 0; // interrupted by a signal, the caller checks why
+		}
+		throw std::runtime_error("Error:" + std::string("epoll_wait: ") + strerror(errno));
+	}
+	for (int i = 0; i < nready; i++){
+		int		fd = events_[i].data.fd;
+		auto	evs = events_[i].events;
+		// the client was removed by an earlier event of this batch
+		if (fd == -1){
+			continue;
+		}
+		// 1) new connections on listening socket, accept it
+		if (fd == listen_fd_){
+			acceptAll(handler);
+			continue;
+		}
+		// 2) other reactors posted replies for our clients
+		if (fd == wake_fd_){
+			handler.onWakeUp();
+			continue;
+		}
+		// 3) check for error or hang-up
+		if (evs & (EPOLLERR | EPOLLHUP)){
+			handler.onClose(fd);
+			continue;
+		}
+		// 4) date to read
+		if (evs & EPOLLIN){
+			handler.onReadable(fd);
+		}
+		// 5) socket has room again. The read above might have removed the client.
+		if ((evs & EPOLLOUT) && events_[i].data.fd != -1){
+			handler.onWritable(fd);
+		}
+	}
+	return nready;
+}
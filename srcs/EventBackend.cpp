@@ -0,0 +1,21 @@
+#include "EventBackend.hpp"
+#include "EpollBackend.hpp"
+#include "UringBackend.hpp"
+#include "Logger.hpp"
+#include <stdexcept>
+
+/**
+ * @brief Build the backend chosen with --backend. When the kernel doesn't
+ * provide what the io_uring backend needs (or io_uring is disabled), the
+ * server keeps working on epoll.
+ */
+std::unique_ptr<EventBackend>	EventBackend::create(BACKENDTYPE type){
+	if (type == BACKENDTYPE::IO_URING){
+		try{
+			return std::make_unique<UringBackend>();
+		} catch (std::runtime_error& e){
+			Logger::log(Logger::WARNING, std::string(e.what()) + ", falling back to epoll");
+		}
+	}
+	return std::make_unique<EpollBackend>();
+}
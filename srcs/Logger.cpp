@@ -11,6 +11,23 @@
 /* ************************************************************************** */
 
 #include "Logger.hpp"
+#include <cstring>
+#include <charconv>
+#include <signal.h>
+
+Logger::Record			Logger::ring_[LOG_RING_SIZE];
+std::atomic<size_t>		Logger::enqueue_pos_{0};
+size_t					Logger::dequeue_pos_ = 0;
+std::atomic<uint64_t>	Logger::dropped_{0};
+std::atomic<bool>		Logger::running_{false};
+LOGPOLICY				Logger::policy_ = LOGPOLICY::DROP;
+std::thread				Logger::writer_;
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+// What format() ends every line with, a cut message is marked just before it
+#define LOG_LINE_END RESET "\n"
+static constexpr size_t	LOG_LINE_END_LEN = sizeof(LOG_LINE_END) - 1;
 
 Logger::~Logger(){
 }
@@ -24,26 +41,171 @@ Logger::~Logger(){
 const std::chrono::system_clock::time_point Logger::start_time{
 	std::chrono::system_clock::now()};
 
-void Logger::log(enum LEVEL level, std::string msg){
-	if (level >= LOG_LEVEL){
-		auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(
-					std::chrono::system_clock::now() - start_time).count();
-		if (level == DEBUG){
-			std::cout << GREEN << diff << " {DEBUG} ";
-		} else if (level == INFO){
-			std::cout << BLUE << diff << " {INFO} ";
-		} else if (level == WARNING){
-			std::cout << ORANGE << diff << " {WARNING} ";
-		} else if (level == ERROR){
-			std::cout << RED << diff << " {ERROR} ";
+void Logger::log(enum LEVEL level, std::string_view msg){
+	if (level < LOG_LEVEL){
+		return;
+	}
+	long long	ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::system_clock::now() - start_time).count();
+	cleanMessage(msg);
+	if (running_.load(std::memory_order_acquire)){
+		while (!push(level, ms, msg)){
+			if (policy_ == LOGPOLICY::DROP){
+				dropped_.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			std::this_thread::yield();
+		}
+		return;
+	}
+	std::string	line;
+	format(line, level, ms, msg);
+	std::cout.write(line.data(), line.size()).flush();
+}
+
+/**
+ * @brief For hot paths: check before building an expensive message.
+ */
+bool Logger::isEnabled(enum LEVEL level){
+	return level >= LOG_LEVEL;
+}
+
+/**
+ * @brief Start the writer thread. It doesn't take the signals, they are for
+ * the event loops.
+ */
+void Logger::start(LOGPOLICY policy){
+	if (running_.load()){
+		return;
+	}
+	for (size_t i = 0; i < LOG_RING_SIZE; i++){
+		ring_[i].seq.store(i, std::memory_order_relaxed);
+	}
+	enqueue_pos_.store(0, std::memory_order_relaxed);
+	dequeue_pos_ = 0;
+	policy_ = policy;
+	running_.store(true, std::memory_order_release);
+
+	sigset_t	blocked;
+	sigset_t	previous;
+	sigfillset(&blocked);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+	writer_ = std::thread(writerLoop);
+	pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+void Logger::stop(){
+	if (!running_.exchange(false)){
+		return;
+	}
+	writer_.join();
+}
+
+/**
+ * @brief Bounded multi-producer queue (Dmitry Vyukov's): a record is free for
+ * position pos when its seq is pos, and holds a message when its seq is
+ * pos + 1. A producer claims a position with one CAS on enqueue_pos_ and
+ * publishes the record by bumping its seq, so the writer never sees a half
+ * written record. False when the ring is full.
+ */
+bool Logger::push(enum LEVEL level, long long ms, std::string_view msg){
+	size_t	pos = enqueue_pos_.load(std::memory_order_relaxed);
+	Record*	record;
+	for (;;){
+		record = &ring_[pos & (LOG_RING_SIZE - 1)];
+		size_t		seq = record->seq.load(std::memory_order_acquire);
+		intptr_t	diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+		if (diff == 0){
+			if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+				break;
+			}
+		} else if (diff < 0){
+			return false; // the writer is a whole lap behind
+		} else{
+			pos = enqueue_pos_.load(std::memory_order_relaxed);
+		}
+	}
+	record->ms = ms;
+	record->level = level;
+	record->cut = msg.size() > LOG_RECORD_TEXT;
+	record->len = static_cast<uint16_t>(record->cut ? LOG_RECORD_TEXT : msg.size());
+	std::memcpy(record->text, msg.data(), record->len);
+	record->seq.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+void Logger::writerLoop(){
+	std::string	batch;
+	while (running_.load(std::memory_order_acquire)){
+		if (drain(batch) == 0){
+			std::this_thread::sleep_for(std::chrono::milliseconds(LOG_WRITER_SLEEP_MS));
+		}
+	}
+	// what was pushed before stop()
+	drain(batch);
+}
+
+/**
+ * @brief Format every published record and write them out with one flush.
+ * Returns how many records were written.
+ */
+size_t Logger::drain(std::string& batch){
+	size_t	n = 0;
+	for (;;){
+		Record&	record = ring_[dequeue_pos_ & (LOG_RING_SIZE - 1)];
+		if (record.seq.load(std::memory_order_acquire) != dequeue_pos_ + 1){
+			break;
+		}
+		format(batch, record.level, record.ms, std::string_view(record.text, record.len));
+		if (record.cut){
+			batch.insert(batch.size() - LOG_LINE_END_LEN, "...");
 		}
-		cleanMessage(msg);
-		std::cout << msg << RESET << std::endl;
+		// free for the producers of the next lap
+		record.seq.store(dequeue_pos_ + LOG_RING_SIZE, std::memory_order_release);
+		dequeue_pos_++;
+		n++;
+	}
+	if (uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed)){
+		long long	ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::system_clock::now() - start_time).count();
+		format(batch, WARNING, ms, std::to_string(dropped) + " log lines dropped, the log ring was full");
+	}
+	if (!batch.empty()){
+		std::cout.write(batch.data(), batch.size()).flush();
+		batch.clear();
+	}
+	return n;
+}
+
+void Logger::format(std::string& out, enum LEVEL level, long long ms, std::string_view msg){
+	char	digits[24];
+	auto	end = std::to_chars(digits, digits + sizeof(digits), ms).ptr;
+
+	if (level == DEBUG){
+		out += GREEN;
+	} else if (level == INFO){
+		out += BLUE;
+	} else if (level == WARNING){
+		out += ORANGE;
+	} else if (level == ERROR){
+		out += RED;
+	}
+	out.append(digits, end - digits);
+	if (level == DEBUG){
+		out += " {DEBUG} ";
+	} else if (level == INFO){
+		out += " {INFO} ";
+	} else if (level == WARNING){
+		out += " {WARNING} ";
+	} else if (level == ERROR){
+		out += " {ERROR} ";
 	}
+	out += msg;
+	out += LOG_LINE_END;
 }
 
-void Logger::cleanMessage(std::string& msg){
-	while (msg.back() == '\n' || msg.back() == '\r'){
-		msg.pop_back();
+void Logger::cleanMessage(std::string_view& msg){
+	while (!msg.empty() && (msg.back() == '\n' || msg.back() == '\r')){
+		msg.remove_suffix(1);
 	}
 }
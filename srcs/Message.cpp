@@ -13,46 +13,63 @@
 #include "Message.hpp"
 #include "Logger.hpp"
 #include <string>
-#include <sstream>
+#include <stdexcept>
 
-Message::Message(std::string& message) :
+ParamList::ParamList() : slots_(), size_(0){}
+
+bool ParamList::push_back(std::string_view token){
+    if (size_ == slots_.size()){
+        return false;
+    }
+    slots_[size_++] = token;
+    return true;
+}
+
+size_t ParamList::size() const{
+    return size_;
+}
+
+bool ParamList::empty() const{
+    return size_ == 0;
+}
+
+std::string_view ParamList::operator[](size_t index) const{
+    return slots_[index];
+}
+
+std::string_view ParamList::at(size_t index) const{
+    if (index >= size_){
+        throw std::out_of_range("ParamList::at: index " + std::to_string(index)
+            + " >= size " + std::to_string(size_));
+    }
+    return slots_[index];
+}
+
+const std::string_view* ParamList::begin() const{
+    return slots_.data();
+}
+
+const std::string_view* ParamList::end() const{
+    return slots_.data() + size_;
+}
+
+Message::Message(std::string_view message) :
       whole_msg_(message),
       number_of_parameters_(0),
-      msg_trailing_(""),
+      msg_trailing_(),
       parameters_(),
       msg_users_(),
       msg_channels_(),
       cmd_type_(INVALID),
-      cmd_string_(""),
+      cmd_string_(),
       passwords_(),
       msg_trailing_empty_(false)
 {
-    initCommandHandlers();
 }
 
 Message::~Message(){
 }
 
-void Message::initCommandHandlers(){
-    command_handlers_ = {
-        {"PASS",   [this](){ cmd_type_ = PASS; return handlePASS(); }},
-        {"NICK",   [this](){ cmd_type_ = NICK; return handleGeneric(); }},
-        {"TOPIC",  [this](){ cmd_type_ = TOPIC; return handleGeneric(); }},
-        {"USER",   [this](){ cmd_type_ = USER; return handleGeneric(); }},
-        {"PRIVMSG",[this](){ cmd_type_ = PRIVMSG; return handleGeneric(); }},
-        {"PART",   [this](){ cmd_type_ = PART; return handleGeneric(); }},
-        {"JOIN",   [this](){ cmd_type_ = JOIN; return handleJOIN(); }},
-        {"QUIT",   [this](){ cmd_type_ = QUIT; return handleGeneric(); }},
-        {"INVITE", [this](){ cmd_type_ = INVITE; return handleGeneric(); }},
-        {"MODE",   [this](){ cmd_type_ = MODE; return handleMODE(); }},
-        {"CAP",   [this](){ cmd_type_ = CAP; return handleCAP(); }},
-        {"PING",   [this](){ cmd_type_ = PING; return handleNoParse(); }},
-        {"WHOIS",   [this](){ cmd_type_ = WHOIS; return handleGeneric(); }},
-        {"WHO",   [this](){ cmd_type_ = WHO; return handleNoParse(); }},
-        {"KICK",   [this](){ cmd_type_ = KICK; return handleKICK(); }}
-    };
-}
-
 bool Message::handleNoParse(){
     return true;
 }
@@ -145,69 +162,101 @@ bool Message::handleMODE(){
     return true;
 }
 
-bool Message::validateParameters(const std::string& command){
-    auto it = command_handlers_.find(command);
-    if (it != command_handlers_.end()){
-        return it->second();
+bool Message::validateParameters(){
+    switch (cmd_type_){
+        case PASS:
+            return handlePASS();
+        case NICK: case TOPIC: case USER: case PRIVMSG: case PART: case QUIT:
+        case INVITE: case WHOIS: case NAMES:
+            return handleGeneric();
+        case JOIN:
+            return handleJOIN();
+        case MODE:
+            return handleMODE();
+        case CAP:
+            return handleCAP();
+        case PING: case PONG: case WHO:
+            return handleNoParse();
+        case KICK:
+            return handleKICK();
+        default:
+            Logger::log(Logger::ERROR, "Unknown command: " + std::string(cmd_string_));
+            return false;
     }
-    Logger::log(Logger::ERROR, "Unknown command: " + command);
-    return false;
+}
+
+// The characters std::isspace() takes as white space in the "C" locale
+static bool isSpace(char c){
+    return c == ' ' || (c >= '\t' && c <= '\r');
 }
 
 /**
- * Transforms the entire message received into a istringstream and extracts
- * one by one all the parts of it separated by spaces, then further separates each
- * word by commas if any are found. The command is saved in thecmd_string_ and the
- * trailing message in msg_trailing, everything else is pushed to the parameters_ vector
- * and then validated separately for each command.
+ * Walks the line once, splitting it into words at white space, then further
+ * separates each word by commas if any are found (empty pieces are dropped).
+ * The first word is the command, saved in cmd_string_. A word starting with ':'
+ * begins the trailing message, msg_trailing_ is the rest of the line after the
+ * ':' up to a newline, without the line's CR/LF. Everything else goes to the
+ * parameters_ and is then validated separately for each command.
+ *
+ * Every token is a view into the line, nothing is copied. Past MSG_MAX_PARAMS
+ * tokens the rest of the parameters are ignored.
  */
 bool Message::parseMessage(){
-    std::istringstream input_stream(whole_msg_);
-    std::string command;
-    std::string     word;
-
-    input_stream >> command;
-    cmd_string_ = command;
-    while (input_stream >> word){
-        if (!word.empty() && word[0] == ':'){
-            std::string rest_of_line;
-            std::getline(input_stream, rest_of_line);
-            // trim the end '\n' and '\r' out
-            while (rest_of_line.back() == '\n' || rest_of_line.back() == '\r'){
-                rest_of_line.pop_back();
-            }
-            if (!rest_of_line.empty()){
-            msg_trailing_ = word.substr(1) + rest_of_line;
-            }
-            else{
-            msg_trailing_ = word.substr(1);
-            if (msg_trailing_.empty()){
-                msg_trailing_empty_ = true;
+    std::string_view    line = whole_msg_;
+    size_t              pos = 0;
+
+    while (pos < line.size() && isSpace(line[pos])){
+        ++pos;
+    }
+    size_t  start = pos;
+    while (pos < line.size() && !isSpace(line[pos])){
+        ++pos;
+    }
+    cmd_string_ = line.substr(start, pos - start);
+    cmd_type_ = CommandTable::lookup(cmd_string_);
+    while (true){
+        while (pos < line.size() && isSpace(line[pos])){
+            ++pos;
+        }
+        if (pos == line.size()){
+            break;
+        }
+        start = pos;
+        while (pos < line.size() && !isSpace(line[pos])){
+            ++pos;
+        }
+        if (line[start] == ':'){
+            size_t  end = line.find('\n', pos);
+            if (end == std::string_view::npos){
+                end = line.size();
             }
+            // trim the end '\n' and '\r' out
+            while (end > pos && (line[end - 1] == '\n' || line[end - 1] == '\r')){
+                --end;
             }
+            msg_trailing_ = line.substr(start + 1, end - start - 1);
+            msg_trailing_empty_ = msg_trailing_.empty();
             break;
         }
-        // trim the end '\n' and '\r' out
-        while (word.back() == '\n' || word.back() == '\r'){
-            word.pop_back();
-        }
-        std::stringstream string_stream(word);
-        std::string token;
-        while (std::getline(string_stream, token, ',')){
-            if (!token.empty()){
+        size_t  token = start;
+        for (size_t i = start; i <= pos; ++i){
+            if (i < pos && line[i] != ','){
+                continue;
+            }
+            if (i > token && parameters_.push_back(line.substr(token, i - token))){
                 ++number_of_parameters_;
-                parameters_.push_back(token);
             }
+            token = i + 1;
         }
     }
-    if (validateParameters(command) == false){
+    if (validateParameters() == false){
         Logger::log(Logger::ERROR, "Validation failed");
         return false;
     }
     return true;
 }
 
-const std::string& Message::getWholeMessage() const{
+std::string_view Message::getWholeMessage() const{
     return whole_msg_;
 }
 
@@ -215,19 +264,19 @@ int Message::getNumberOfParameters() const{
     return number_of_parameters_;
 }
 
-const std::string& Message::getTrailing() const{
+std::string_view Message::getTrailing() const{
     return msg_trailing_;
 }
 
-const std::vector<std::string>& Message::getParameters() const{
+const ParamList& Message::getParameters() const{
     return parameters_;
 }
 
-const std::vector<std::string>& Message::getUsers() const{
+const ParamList& Message::getUsers() const{
     return msg_users_;
 }
 
-const std::vector<std::string>& Message::getChannels() const{
+const ParamList& Message::getChannels() const{
     return msg_channels_;
 }
 
@@ -235,11 +284,11 @@ COMMANDTYPE Message::getCommandType() const{
     return cmd_type_;
 }
 
-const std::string& Message::getCommandString() const{
+std::string_view Message::getCommandString() const{
     return cmd_string_;
 }
 
-const std::vector<std::string>& Message::getPasswords() const{
+const ParamList& Message::getPasswords() const{
     return passwords_;
 }
 
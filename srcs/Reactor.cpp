@@ -0,0 +1,72 @@
+#include "Reactor.hpp"
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+Reactor::Reactor(int id, BACKENDTYPE backend) : id_(id), serv_fd_(-1), wake_fd_(-1), clients_(id){
+	backend_ = EventBackend::create(backend);
+	wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wake_fd_ == -1){
+		throw std::runtime_error("Error: eventfd failed");
+	}
+	try{
+		backend_->addWakeUpFd(wake_fd_);
+	} catch (...){
+		close(wake_fd_);
+		throw;
+	}
+}
+
+/**
+ * The backend goes first, io_uring may still have operations on the sockets.
+ */
+Reactor::~Reactor(){
+	backend_.reset();
+	if (serv_fd_ != -1){
+		close(serv_fd_);
+	}
+	close(wake_fd_);
+}
+
+int	Reactor::getId() const{
+	return id_;
+}
+
+/**
+ * @brief Called from other threads. Only the first delivery of a batch writes
+ * the eventfd, the owner drains the whole inbox per wake up.
+ */
+void	Reactor::post(Delivery&& delivery){
+	bool	was_empty;
+	{
+		std::lock_guard<std::mutex>	lock(inbox_mutex_);
+		was_empty = inbox_.empty();
+		inbox_.push_back(std::move(delivery));
+	}
+	if (was_empty){
+		wakeUp();
+	}
+}
+
+/**
+ * @brief Hand everything posted so far to the owner. The two vectors are swapped,
+ * so neither gives its capacity back between batches.
+ */
+std::vector<Delivery>&	Reactor::takeInbox(){
+	drained_.clear();
+	std::lock_guard<std::mutex>	lock(inbox_mutex_);
+	drained_.swap(inbox_);
+	return drained_;
+}
+
+void	Reactor::wakeUp(){
+	uint64_t	one = 1;
+	ssize_t		n = write(wake_fd_, &one, sizeof(one));
+	(void)n; // EAGAIN means the counter is already non-zero, the owner wakes up anyway
+}
+
+void	Reactor::clearWakeUp(){
+	uint64_t	value;
+	ssize_t		n = read(wake_fd_, &value, sizeof(value));
+	(void)n;
+}
@@ -0,0 +1,152 @@
+#include "RecvBuffer.hpp"
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define RECVBUF_X86
+#endif
+
+// Push the position after every LF of base[from, to)
+using ScanFunc = void (*)(const char* base, size_t from, size_t to, std::vector<size_t>& ends);
+
+static void	scanScalar(const char* base, size_t from, size_t to, std::vector<size_t>& ends){
+	while (from < to){
+		const char*	lf = static_cast<const char*>(std::memchr(base + from, '\n', to - from));
+		if (!lf){
+			return;
+		}
+		from = lf - base + 1;
+		ends.push_back(from);
+	}
+}
+
+#ifdef RECVBUF_X86
+static void	scanSSE2(const char* base, size_t from, size_t to, std::vector<size_t>& ends){
+	const __m128i	lf = _mm_set1_epi8('\n');
+	for (; from + 16 <= to; from += 16){
+		__m128i		chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + from));
+		unsigned	mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf));
+		while (mask){
+			ends.push_back(from + __builtin_ctz(mask) + 1);
+			mask &= mask - 1;
+		}
+	}
+	scanScalar(base, from, to, ends);
+}
+
+__attribute__((target("avx2")))
+static void	scanAVX2(const char* base, size_t from, size_t to, std::vector<size_t>& ends){
+	const __m256i	lf = _mm256_set1_epi8('\n');
+	for (; from + 32 <= to; from += 32){
+		__m256i		chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + from));
+		unsigned	mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, lf));
+		while (mask){
+			ends.push_back(from + __builtin_ctz(mask) + 1);
+			mask &= mask - 1;
+		}
+	}
+	scanSSE2(base, from, to, ends);
+}
+#endif
+
+static ScanFunc	pickScan(){
+#ifdef RECVBUF_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")){
+		return scanAVX2;
+	}
+	return scanSSE2;
+#else
+	return scanScalar;
+#endif
+}
+
+static const ScanFunc	scanLines = pickScan();
+
+RecvBuffer::RecvBuffer() : start_(0), end_(0), scan_(0), next_line_(0){
+}
+
+RecvBuffer::~RecvBuffer(){
+}
+
+/**
+ * @brief Make room for at least min_room bytes at the end: first by moving the
+ * unconsumed bytes to the front, then by growing the block.
+ *
+ * @return where the next bytes go, writable() tells how many fit.
+ */
+char*	RecvBuffer::prepareWrite(size_t min_room){
+	if (data_.size() - end_ < min_room && start_ > 0){
+		std::memmove(data_.data(), data_.data() + start_, end_ - start_);
+		for (size_t i = next_line_; i < line_ends_.size(); i++){
+			line_ends_[i] -= start_;
+		}
+		end_ -= start_;
+		scan_ -= start_;
+		start_ = 0;
+	}
+	if (data_.size() - end_ < min_room){
+		data_.resize(std::max(data_.size() * 2, end_ + min_room));
+	}
+	return data_.data() + end_;
+}
+
+size_t	RecvBuffer::writable() const{
+	return data_.size() - end_;
+}
+
+void	RecvBuffer::commitWrite(size_t n){
+	end_ += n;
+}
+
+void	RecvBuffer::append(const char* data, size_t len){
+	std::memcpy(prepareWrite(len), data, len);
+	commitWrite(len);
+}
+
+/**
+ * @brief Queue the ends of the lines in the bytes received since the last scan.
+ *
+ * @return whether a complete line is waiting.
+ */
+bool	RecvBuffer::scan(){
+	if (next_line_ == line_ends_.size() && scan_ < end_){
+		line_ends_.clear();
+		next_line_ = 0;
+		scanLines(data_.data(), scan_, end_, line_ends_);
+		scan_ = end_;
+	}
+	return next_line_ < line_ends_.size();
+}
+
+/**
+ * @brief Take the next line (its CRLF or LF included) from the front.
+ */
+bool	RecvBuffer::nextLine(std::string_view& line){
+	if (!scan()){
+		if (start_ == end_ && data_.size() > RECVBUF_KEEP){
+			std::vector<char>().swap(data_);
+			start_ = end_ = scan_ = 0;
+		}
+		return false;
+	}
+	size_t	line_end = line_ends_[next_line_++];
+	line = std::string_view(data_.data() + start_, line_end - start_);
+	start_ = line_end;
+	if (start_ == end_){
+		// everything consumed, the next write starts at the front again
+		start_ = end_ = scan_ = 0;
+		line_ends_.clear();
+		next_line_ = 0;
+	}
+	return true;
+}
+
+bool	RecvBuffer::hasLine(){
+	return scan();
+}
+
+size_t	RecvBuffer::size() const{
+	return end_ - start_;
+}
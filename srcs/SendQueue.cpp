@@ -0,0 +1,136 @@
+#include "SendQueue.hpp"
+#include <sys/uio.h> // for writev()
+#include <cerrno>
+
+SendQueue::SendQueue() : front_offset_(0), n_bytes_(0), limit_(SENDQ_LIMIT){
+}
+
+SendQueue::SendQueue(size_t limit) : front_offset_(0), n_bytes_(0), limit_(limit){
+}
+
+SendQueue::~SendQueue(){
+}
+
+/**
+ * @brief Append a reply to the end of the queue.
+ *
+ * @return
+ *  true: the data is queued;
+ *  false: the data would push the queue over its limit, nothing is queued.
+ */
+bool	SendQueue::push(const std::string& data){
+	if (data.empty()){
+		return true;
+	}
+	if (n_bytes_ + data.size() > limit_){
+		return false;
+	}
+	chunks_.push_back(makePayload(data));
+	n_bytes_ += data.size();
+	return true;
+}
+
+/**
+ * @brief Append a shared payload, only the reference is queued.
+ */
+bool	SendQueue::push(const Payload& payload){
+	if (payload->empty()){
+		return true;
+	}
+	if (n_bytes_ + payload->size() > limit_){
+		return false;
+	}
+	chunks_.push_back(payload);
+	n_bytes_ += payload->size();
+	return true;
+}
+
+/**
+ * @brief Point up to max_iov iovecs at the unsent data, oldest first. The
+ * queue isn't changed, consume() drops what was actually sent. With refs, the
+ * payload behind every iovec is stored there too, so the caller can keep the
+ * bytes alive after consume().
+ *
+ * @return number of iovecs filled, n_bytes gets the bytes they cover.
+ */
+int	SendQueue::gather(struct iovec* iov, int max_iov, size_t& n_bytes, Payload* refs) const{
+	int		n_iov = 0;
+	size_t	offset = front_offset_;
+
+	n_bytes = 0;
+	for (auto it = chunks_.begin(); it != chunks_.end() && n_iov < max_iov; ++it){
+		iov[n_iov].iov_base = const_cast<char*>((*it)->data()) + offset;
+		iov[n_iov].iov_len = (*it)->size() - offset;
+		n_bytes += iov[n_iov].iov_len;
+		if (refs){
+			refs[n_iov] = *it;
+		}
+		offset = 0;
+		n_iov++;
+	}
+	return n_iov;
+}
+
+/**
+ * @brief Drop n bytes from the front of the queue, the chunks that were sent
+ * completely are freed.
+ */
+void	SendQueue::consume(size_t n){
+	n_bytes_ -= n;
+	while (n > 0){
+		size_t	chunk_left = chunks_.front()->size() - front_offset_;
+		if (n < chunk_left){
+			front_offset_ += n;
+			break;
+		}
+		n -= chunk_left;
+		chunks_.pop_front();
+		front_offset_ = 0;
+	}
+}
+
+/**
+ * @brief Write queued data to the socket until the queue is empty or the
+ * kernel buffer is full. Up to SENDQ_IOV_BATCH chunks go out per writev().
+ *
+ * @return bytes written during this call, or -1 on a socket error (not EAGAIN).
+ */
+ssize_t	SendQueue::flush(int fd){
+	struct iovec	iov[SENDQ_IOV_BATCH];
+	ssize_t			total = 0;
+
+	while (!chunks_.empty()){
+		size_t	requested;
+		int		n_iov = gather(iov, SENDQ_IOV_BATCH, requested);
+		ssize_t	n = writev(fd, iov, n_iov);
+		if (n < 0){
+			if (errno == EAGAIN || errno == EWOULDBLOCK){
+				break;
+			}
+			if (errno == EINTR){
+				continue;
+			}
+			return -1;
+		}
+		total += n;
+		consume(n);
+		if (!chunks_.empty() && static_cast<size_t>(n) < requested){
+			break; // short write, the socket buffer is full
+		}
+	}
+	return total;
+}
+
+bool	SendQueue::empty() const{
+	return n_bytes_ == 0;
+}
+
+size_t	SendQueue::size() const{
+	return n_bytes_;
+}
+
+void	SendQueue::clear(){
+	chunks_.clear();
+	front_offset_ = 0;
+	n_bytes_ = 0;
+}
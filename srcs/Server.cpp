@@ -11,11 +11,13 @@
 /* ************************************************************************** */
 
 #include "Server.hpp"
+#include <netinet/tcp.h> // for TCP_CORK
 
 /**
  * Parsing the parameters and initilize the pass and port variables
  */
-Server::Server(std::string port, std::string password){
+Server::Server(std::string port, std::string password, const ServerConfig& config)
+	: config_(config){
 	// 1. parsing for port
 	for (auto it : port){
 		if (!isdigit(it)){
@@ -44,75 +46,65 @@ Server::Server(std::string port, std::string password){
 				+ std::string(1,c) + "'\n" + PASSWORD_RULE);
 		}
 	}
+	// 3. flood control costs, the defaults and then the --flood-cost overrides
+	command_costs_.resize(INVALID + 1);
+	for (int type = 0; type <= INVALID; type++){
+		command_costs_[type] = CommandTable::get(static_cast<COMMANDTYPE>(type)).cost;
+	}
+	for (const auto& [name, cost] : config_.flood_costs){
+		COMMANDTYPE	type = CommandTable::lookup(name);
+		if (type == INVALID){
+			throw std::invalid_argument("Error: --flood-cost: unknown command '" + name + "'");
+		}
+		command_costs_[type] = cost;
+	}
 	serv_port_ = port_num;
 	serv_passwd_ = password;
-	epoll_fd_ = epoll_create1(0);
-	if (epoll_fd_ == -1){
-		throw std::runtime_error("Error: epoll_create1 failed");
-	}
 	n_channel_ = 0;
 	n_user_ = 0;
+	fanout_epoch_ = 0;
+	server_ = this;
 }
 
 Server*	Server::server_ = nullptr;
 
-volatile sig_atomic_t	Server::keep_running_ = 1;
+std::atomic<bool>	Server::keep_running_{true};
 
+thread_local Reactor*	Server::reactor_ = nullptr;
 
 
-/**
- * @brief Define the commands that an unregistered client can execute. Currenctly
- * set to PASS, NICK, USER and QUIT
- */
-const std::set<COMMANDTYPE> Server::pre_registration_allowed_commands_ = {
-	PASS,
-	NICK,
-	USER,
-	CAP,
-	PING,
-	WHOIS,
-	WHO,
-	QUIT
-};
-
-/**
- * @brief Define the commands that only an operator can execute. Currenctly
- * set to: KICK, INVITE and MODE
- */
-const std::set<COMMANDTYPE> Server::operator_commands_ = {
-	KICK,
-	INVITE,
-	MODE
-};
 
 /**
- * @brief Setup the map for commands and execute functions
+ * @brief The execute function of every command, indexed by COMMANDTYPE
  */
-const std::unordered_map<COMMANDTYPE, Server::executeFunc> Server::execute_map_ = {
-	{PASS, &Server::passCommand},
-	{NICK, &Server::nickCommand},
-	{USER, &Server::userCommand},
-	{PRIVMSG, &Server::privmsgCommand},
-	{JOIN, &Server::joinCommand},
-	{PART, &Server::partCommand},
-	{KICK, &Server::kickUser},
-	{INVITE, &Server::inviteUser},
-	{TOPIC, &Server::topic},
-	{MODE, &Server::mode},
-	{CAP, &Server::capCommand},
-	{PING, &Server::pingCommand},
-	{WHOIS, &Server::whoisCommand},
-	{WHO, &Server::whoCommand},
-	{QUIT, &Server::quitCommand}
-};
-
+const std::array<Server::executeFunc, INVALID> Server::execute_table_ = [](){
+	std::array<Server::executeFunc, INVALID>	table{};
+	table[PASS] = &Server::passCommand;
+	table[NICK] = &Server::nickCommand;
+	table[USER] = &Server::userCommand;
+	table[PRIVMSG] = &Server::privmsgCommand;
+	table[JOIN] = &Server::joinCommand;
+	table[PART] = &Server::partCommand;
+	table[KICK] = &Server::kickUser;
+	table[INVITE] = &Server::inviteUser;
+	table[TOPIC] = &Server::topic;
+	table[MODE] = &Server::mode;
+	table[CAP] = &Server::capCommand;
+	table[PING] = &Server::pingCommand;
+	table[PONG] = &Server::pongCommand;
+	table[WHOIS] = &Server::whoisCommand;
+	table[WHO] = &Server::whoCommand;
+	table[NAMES] = &Server::namesCommand;
+	table[QUIT] = &Server::quitCommand;
+	return table;
+}();
 
 Server::~Server(){
 }
 
 void	Server::signalHandler(int signum){
 	if (signum == SIGINT || signum == SIGTERM){
-		Server::keep_running_ = 0;
+		Server::keep_running_ = false;
 	}
 }
 
@@ -133,22 +125,25 @@ void	Server::setupSignalHandlers(){
  * 		2) Setsockopt;;
  * 		3) Bind;
  * 		4) Listen;
+ * Every reactor runs these steps for its own listening socket. They all bind
+ * the same port, SO_REUSEPORT makes the kernel spread new connections over them.
  */
-void	Server::setupServSocket(){
+void	Server::setupServSocket(Reactor& reactor){
 	// 1. Socket createtion
 	Logger::log(Logger::INFO, "initServer::Socket createtion ");
-	serv_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-	if (serv_fd_ == -1){
+	reactor.serv_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+	if (reactor.serv_fd_ == -1){
 		throw std::runtime_error("Error: failed to create socket for the server");
 	}
 	// 2. enable port reuse
 	int opt = 1;
 	// pass the value of opt to "const void* optval", in this case it is "SO_REUSEADDR"
 	// or "SO_REUSEPORT", when the value is 1, it means turn it on; when the value is '0'
-	// it means turn it off
+	// it means turn it off. The option names are values, not bit flags, so each
+	// one needs its own call.
 	Logger::log(Logger::INFO, "initServer::Set socket option");
-	if (setsockopt(serv_fd_, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt,
-				sizeof(opt)) < 0){
+	if (setsockopt(reactor.serv_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0
+		|| setsockopt(reactor.serv_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0){
 		throw std::runtime_error("Error: setsockopt");
 	}
 	// 3. Bind to all the avaiable IPs and server port
@@ -157,180 +152,375 @@ void	Server::setupServSocket(){
 	serv_addr_.sin_family = AF_INET;
 	serv_addr_.sin_addr.s_addr = INADDR_ANY;
 	serv_addr_.sin_port = htons(this->serv_port_);
-	if (bind(serv_fd_, (sockaddr*)&serv_addr_, sizeof(serv_addr_)) < 0){
+	if (bind(reactor.serv_fd_, (sockaddr*)&serv_addr_, sizeof(serv_addr_)) < 0){
 		throw std::runtime_error("Error: bind failed");
 	}
 	// 4. listen, the backlog number(now set to 10) can be changed based on the
 	// performance during testing
 	// After do listen(fd, backlog), now the "fd" become a listening fd.
-	if (listen(serv_fd_, 10) == -1){
+	if (listen(reactor.serv_fd_, 10) == -1){
 		throw std::runtime_error("Error: something wrong happended on listen");
 	}
 
-	// 5. register listeing socket for read(EPOLLIN)
-	int flags = fcntl(serv_fd_, F_GETFL, 0);
-	fcntl(serv_fd_, F_SETFL, flags | O_NONBLOCK);
-
-	struct epoll_event ev{};
-	// EPOLLIN for read events + EPOLLET for edge-triggered
-	ev.events = EPOLLIN | EPOLLET;
-	ev.data.fd = serv_fd_;
-	if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, serv_fd_, &ev) == -1){
-		throw std::runtime_error("Error: epoll_ctl ADD listen_fd failed");
-	}
-	// prepare event buffer
-	events_.resize(MAX_EVENTS);
+	// 5. register listeing socket with the reactor's backend
+	int flags = fcntl(reactor.serv_fd_, F_GETFL, 0);
+	fcntl(reactor.serv_fd_, F_SETFL, flags | O_NONBLOCK);
+	reactor.backend_->addListener(reactor.serv_fd_);
 
 	// add log message
-	Logger::log(Logger::INFO, "Server listening on port " + std::to_string(serv_port_));
+	Logger::log(Logger::INFO, "Server listening on port " + std::to_string(serv_port_)
+		+ " (reactor " + std::to_string(reactor.getId()) + ", " + reactor.backend_->getName() + ")");
 }
 
+/**
+ * @brief Start config_.workers reactors. Reactor 0 runs on the calling thread,
+ * the others get a thread each. Signals are blocked in the worker threads, so
+ * SIGINT/SIGTERM always interrupt the main thread, which then wakes the workers
+ * up to let them see keep_running_ and stop.
+ */
 void	Server::startServer(){
 	setupSignalHandlers();
-	setupServSocket();
-	while (keep_running_){
-		// Wait indefinitely for events
-		// the return value of epoll_wait():
-		// > 0  Number of file descriptors that are ready for the requested I/O.
-		// =0   Timeout occurred — no file descriptors were ready
-		// < 0  Error occurred — check errno for the specific error cause.
-		int nready = epoll_wait(epoll_fd_, events_.data(), events_.size(), -1);
-		if (nready < 0){
-			if (errno == EINTR){
-				continue; // restart on signal
-			}
-			throw std::runtime_error("Error:" + std::string("epoll_wait: ") + strerror(errno));
-		}
-		for (int i = 0; i < nready; i++){
-			int		fd = events_[i].data.fd;
-			auto	evs = events_[i].events;
-			// 1) new connections on listening socket, accept it
-			if (fd == serv_fd_){
-				acceptNewClient();
-				Logger::log(Logger::DEBUG, "Active clients: " +
-							std::to_string(clients_.size()));
-				continue;
-			}
-			// 2) check for error or hang-up
-			else if (evs & (EPOLLERR | EPOLLHUP)){
-				removeClient(*(clients_.find(fd)->second), "disconnected");
-				Logger::log(Logger::INFO, "one client is disoneccted:" + std::to_string(fd));
-				continue;
-			}
-			// 3) date to read
-			else if (evs & EPOLLIN){
-				try {
-					processDataFromClient(i);
-				}catch (std::invalid_argument& e){
-					Logger::log(Logger::WARNING, e.what());
-				} catch (std::exception& e){
-					Logger::log(Logger::ERROR, e.what());
-				}
+	for (int i = 0; i < config_.workers; i++){
+		reactors_.push_back(std::make_unique<Reactor>(i, config_.backend));
+		setupServSocket(*reactors_.back());
+	}
+
+	std::vector<std::thread>	workers;
+	sigset_t	blocked;
+	sigset_t	previous;
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGINT);
+	sigaddset(&blocked, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+	for (size_t i = 1; i < reactors_.size(); i++){
+		workers.emplace_back([this, i](){
+			try{
+				runReactor(*reactors_[i]);
+			} catch (std::exception& e){
+				Logger::log(Logger::ERROR, e.what());
+				stopReactors();
 			}
+		});
+	}
+	pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+	try{
+		runReactor(*reactors_[0]);
+	} catch (...){
+		stopReactors();
+		for (auto& worker : workers){
+			worker.join();
 		}
+		cleanServer();
+		throw;
+	}
+	stopReactors();
+	for (auto& worker : workers){
+		worker.join();
 	}
 	cleanServer();
 	return;
 }
 
+void	Server::stopReactors(){
+	keep_running_ = false;
+	for (auto& reactor : reactors_){
+		reactor->wakeUp();
+	}
+}
+
+/**
+ * @brief The event loop of one reactor. The backend calls back the on*()
+ * handlers below for every event of the batch.
+ */
+void	Server::runReactor(Reactor& reactor){
+	reactor_ = &reactor;
+	while (keep_running_){
+		// the clients that were already waiting get their turn after the events,
+		// the ones queued while handling the events wait for the next tick
+		size_t	n_ready = reactor.ready_list_.size();
+		// Wait for events, or until queued work (flushes, disconnects, corked
+		// sockets) is due. A signal makes wait() return early.
+		reactor.backend_->wait(computeWaitTimeout(), *this);
+		serveReadyClients(n_ready);
+		reactor.timers_.advance([this](int fd){ onClientTimer(fd); });
+		reactor.flood_timers_.advance([this](int fd){ onFloodTimer(fd); });
+		// end of the tick: drop the marked clients, then write everything that
+		// was queued during this iteration
+		disconnectMarkedClients();
+		flushPendingClients();
+		uncorkExpiredClients();
+		// nothing refers to the clients removed in this tick anymore
+		reactor.clients_.collect();
+	}
+}
+
 void	Server::cleanServer(){
 	Logger::log(Logger::INFO, "Shutting down Server");
-	for (auto const& [fd, cli] : clients_) {
-		epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
-		close(fd);
-	}
-	clients_.clear();
-	close(epoll_fd_);
-	close(serv_fd_);
-}
-
-/**
- * @brief This function will accept all the pending connections at once.
- */
-void	Server::acceptNewClient(){
-	// Process all pending connections at once before processing other events
-	while (true) {
-        sockaddr_in client_addr;
-        socklen_t  clientLen = sizeof(client_addr);
-        int client_fd = accept(serv_fd_,
-                               reinterpret_cast<sockaddr*>(&client_addr),
-                               &clientLen);
-        if (client_fd < 0) {
-            // No more pending connections
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                return ;
-            }
-            // real errors
-            throw std::runtime_error("accept failed: " + std::string(strerror(errno)));
-        }
-
-		// get the host information
-		char host[INET_ADDRSTRLEN];
+	for (auto& reactor : reactors_){
+		reactor->clients_.forEach([](Client& cli){ close(cli.getSocketFd()); });
+	}
+	// closes the backend, listening and eventfd sockets of every reactor
+	reactors_.clear();
+}
+
+/**
+ * @brief A new connection was accepted by the reactor's backend, the socket is
+ * already non-blocking.
+ */
+void	Server::onAccept(int client_fd){
+	// get the host information
+	sockaddr_in	client_addr;
+	socklen_t	clientLen = sizeof(client_addr);
+	char		host[INET_ADDRSTRLEN] = "unknown";
+	if (getpeername(client_fd, reinterpret_cast<sockaddr*>(&client_addr), &clientLen) == 0){
 		inet_ntop(AF_INET, &client_addr.sin_addr, host, INET_ADDRSTRLEN);
+	}
 
-        // setting non-blockning mode
-        int flags = fcntl(client_fd, F_GETFL, 0);
-        fcntl(client_fd, F_SETFL, flags | O_NONBLOCK);
-
-        // Register new client into epoll
-        epoll_event ev{};
-        ev.events = EPOLLIN;
-        ev.data.fd = client_fd;
-        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &ev) == -1) {
-            close(client_fd);
-			cleanServer();
-            throw std::runtime_error("epoll_ctl ADD client failed");
-        }
-		// checking if the server has reached its user maximum
-		if (n_user_ >= SERVER_USER_LIMIT){
-			std::string response = "Server has reached its user maximum";
-			// send the error response to the fd
-			int	n_bytes = send(client_fd, response.c_str(), response.length(), MSG_DONTWAIT);
-			if (n_bytes < 0){
-				Logger::log(Logger::WARNING, "Failed to send data to user " + std::to_string(client_fd) +
-				": " + response);
-			} else {
-				Logger::log(Logger::DEBUG, "Sent successfully "+ std::to_string(client_fd) + ": " + response);
-			}
-			Logger::log(Logger::ERROR, "Server has reached its user maximum");
-			close(client_fd);
-			return;
+	std::lock_guard<std::mutex>	lock(state_mutex_);
+	// checking if the server has reached its user maximum
+	if (n_user_ >= SERVER_USER_LIMIT){
+		std::string response = "Server has reached its user maximum";
+		// send the error response to the fd
+		int	n_bytes = send(client_fd, response.c_str(), response.length(), MSG_DONTWAIT);
+		if (n_bytes < 0){
+			Logger::log(Logger::WARNING, "Failed to send data to user " + std::to_string(client_fd) +
+			": " + response);
+		} else {
+			Logger::log(Logger::DEBUG, "Sent successfully "+ std::to_string(client_fd) + ": " + response);
 		}
+		Logger::log(Logger::ERROR, "Server has reached its user maximum");
+		close(client_fd);
+		return;
+	}
 
-		// Because the Client(client_fd) will return client&, but in Clients_
-		// the key value is std::shared_ptr type. So need use "std::make_shared"
-		// to match the return value
-        clients_[client_fd] = std::make_shared<Client>(client_fd, host);
-		n_user_++;
-        Logger::log(Logger::INFO, "New client " + std::to_string(client_fd));
-    }
+	// Register new client with the backend
+	try{
+		reactor_->backend_->addClient(client_fd);
+	} catch (...){
+		close(client_fd);
+		throw;
+	}
+
+	// The client is constructed in the reactor's slot for the fd, no allocation
+	// unless the fd is the first of a new chunk of slots
+	Client&	client = reactor_->clients_.add(client_fd, hosts_.intern(host));
+	n_user_++;
+	armClientTimer(client);
+	Logger::log(Logger::INFO, "New client " + std::to_string(client_fd)
+		+ " on reactor " + std::to_string(reactor_->getId()));
+	Logger::log(Logger::DEBUG, "Active clients: " + std::to_string(reactor_->clients_.size()));
+}
+
+void	Server::onWakeUp(){
+	drainInbox();
+}
+
+/**
+ * @brief The socket has room again (epoll) or the previous send completed
+ * (io_uring), send what is left in the client's queue.
+ */
+void	Server::onWritable(int fd){
+	if (Client* client = reactor_->clients_.get(fd)){
+		flushClient(*client);
+	}
+}
+
+/**
+ * @brief Error or hang-up on the client socket.
+ */
+void	Server::onClose(int fd){
+	Client*	client = reactor_->clients_.get(fd);
+	if (!client){
+		return;
+	}
+	std::lock_guard<std::mutex>	lock(state_mutex_);
+	removeClient(*client, "disconnected");
+	Logger::log(Logger::INFO, "one client is disoneccted:" + std::to_string(fd));
 }
 
 /**
- * @brief This function will first try to receive the data from client socket first. If
- * receive successfully, then store it in client instantiation; otherwise, it means
- * the client wants to close the connection. Second, if the receive the client data
- * succeffuly, then get the line separate by CRLF, saving into buffer. then parse it,
- * execute it.
+ * @brief Queue the replies other reactors produced for our clients. A delivery
+ * for a client that is gone (or whose fd now belongs to a new client) is dropped.
  */
-void	Server::processDataFromClient(int idx){
-	int	client_fd = events_[idx].data.fd;
-	std::shared_ptr<Client> client = clients_[client_fd];
-	if (!client->receiveRawData()){
+void	Server::drainInbox(){
+	reactor_->clearWakeUp();
+	for (const Delivery& delivery : reactor_->takeInbox()){
+		Client*	client = reactor_->clients_.get(delivery.client);
+		if (!client){
+			continue;
+		}
+		queueToClient(*client, delivery.data, delivery.traffic);
+	}
+}
+
+/**
+ * @brief The socket is readable (epoll). This function will first try to receive
+ * the data from client socket first. If receive successfully, then store it in
+ * client instantiation; otherwise, it means the client wants to close the
+ * connection.
+ * A client that still has lines waiting in the ready list, is throttled or
+ * lagging (SENDQPOLICY::LAG), isn't read: the data stays in the socket until the backlog is worked off, so
+ * a flooding client can't grow its receive buffer without bounds.
+ */
+void	Server::onReadable(int client_fd){
+	// a client removed while its commands run (QUIT) lives until the end of the tick
+	Client*	client = reactor_->clients_.get(client_fd);
+	if (!client || client->isInReadyList() || isInputPaused(*client)){
+		return;
+	}
+	bool	received = client->receiveRawData(config_.tick_bytes);
+
+	std::lock_guard<std::mutex>	lock(state_mutex_);
+	if (!received){
 		Logger::log(Logger::INFO, "Client '" + std::to_string(client_fd) + "' disconnected");
 		removeClient(*client, "Client disconnect");
 		return;
 	}
-	std::string	buffer;
-	// extract one line command/message that separate by CRLF
-	while (client->getNextMessage(buffer)){
+	processMessages(*client);
+}
+
+/**
+ * @brief The backend already received the data (io_uring), data points into
+ * one of its receive buffers and is only valid during this call. A client in
+ * the ready list only buffers it, its turn comes in serveReadyClients(); so
+ * does a paused one, until its flood timer fires or it caught up.
+ */
+void	Server::onData(int client_fd, const char* data, size_t len){
+	Client*	client = reactor_->clients_.get(client_fd);
+	if (!client){
+		return;
+	}
+	client->appendRawData(data, len);
+	if (client->isInReadyList() || isInputPaused(*client)){
+		return;
+	}
+	std::lock_guard<std::mutex>	lock(state_mutex_);
+	processMessages(*client);
+}
+
+/**
+ * @brief Get the lines separate by CRLF from the client's receive buffer, then
+ * parse and execute them. The caller holds state_mutex_ and a reference to the
+ * client.
+ * A client gets at most tick_commands commands and tick_bytes bytes per tick,
+ * whatever is left puts it at the end of the ready list, so one client pasting
+ * thousands of lines doesn't hold up the others.
+ * Over a longer run the flood control token bucket decides: every command
+ * pays its cost, a client that runs out is throttled until it earned enough
+ * tokens again. Nothing is dropped, the lines wait in the receive buffer.
+ */
+void	Server::processMessages(Client& client){
+	int					client_fd = client.getSocketFd();
+	int					n_commands = 0;
+	size_t				n_bytes = 0;
+	std::string_view	line;
+	auto				now = std::chrono::steady_clock::now();
+	bool				flood_control = config_.flood_rate > 0;
+	TokenBucket&		bucket = client.getFloodBucket();
+
+	if (flood_control){
+		bucket.refill(config_.flood_rate, config_.flood_burst, now);
+	}
+	// extract one line command/message that separate by CRLF or LF
+	while (n_commands < config_.tick_commands && n_bytes < static_cast<size_t>(config_.tick_bytes)
+		&& (!flood_control || bucket.hasTokens()) && client.getNextMessage(line)){
+		n_commands++;
+		n_bytes += line.size();
 		try{
-			Message	msg(buffer);
+			Message	msg(line);
 			msg.parseMessage();
-			executeCommand(msg, *client);
+			COMMANDTYPE	type = msg.getCommandType();
+			client.touch(now, type != PING && type != PONG);
+			if (flood_control){
+				if (bucket.take(command_costs_[type])){
+					client.addFloodPoints(command_costs_[type]);
+				}
+			}
+			executeCommand(msg, client);
 		} catch (std::exception& e){
 			Logger::log(Logger::WARNING, e.what());
 		}
+		// stop when the command removed the client (QUIT) or its send queue overflowed
+		if (client.isMarkedForDisconnect() || reactor_->clients_.get(client_fd) != &client){
+			return;
+		}
+		// lagging under SENDQPOLICY::LAG, onSendqLow() picks it up again
+		if (isInputPaused(client)){
+			return;
+		}
+	}
+	if (client.hasNextMessage()){
+		if (flood_control && !bucket.hasTokens()){
+			throttleClient(client);
+		} else {
+			scheduleReady(client);
+		}
+	}
+}
+
+void	Server::scheduleReady(Client& cli){
+	if (!cli.isInReadyList()){
+		cli.setInReadyList(true);
+		reactor_->ready_list_.push_back(cli.getSocketFd());
+	}
+}
+
+/**
+ * @brief Stop reading and serving the client until its bucket has tokens again.
+ */
+void	Server::throttleClient(Client& cli){
+	if (cli.isThrottled()){
+		return;
+	}
+	cli.setThrottled(true);
+	reactor_->flood_timers_.arm(cli.getFloodTimer(),
+		cli.getFloodBucket().timeUntilTokens(config_.flood_rate));
+	updateClientEvents(cli);
+	Logger::log(Logger::DEBUG, "Throttling client " + std::to_string(cli.getSocketFd()));
+}
+
+/**
+ * @brief The throttled client earned some tokens back: read it again and give
+ * it a turn in the next tick.
+ */
+void	Server::onFloodTimer(int fd){
+	Client*	client = reactor_->clients_.get(fd);
+	if (!client || !client->isThrottled()){
+		return;
+	}
+	Client&	cli = *client;
+	cli.setThrottled(false);
+	updateClientEvents(cli);
+	if (!isInputPaused(cli) && cli.hasNextMessage()){
+		scheduleReady(cli);
+	}
+}
+
+/**
+ * @brief Give the first n clients of the ready list their next budget. The
+ * ones that still have lines left go to the end of the list again.
+ */
+void	Server::serveReadyClients(size_t n){
+	Reactor&	reactor = *reactor_;
+	n = std::min(n, reactor.ready_list_.size());
+	if (n == 0){
+		return;
+	}
+	std::lock_guard<std::mutex>	lock(state_mutex_);
+	for (size_t i = 0; i < n; i++){
+		int	fd = reactor.ready_list_.front();
+		reactor.ready_list_.pop_front();
+		Client*	client = reactor.clients_.get(fd);
+		// gone, or the fd belongs to a new client by now
+		if (!client || !client->isInReadyList()){
+			continue;
+		}
+		client->setInReadyList(false);
+		// a paused client is back in the list when it may go on
+		if (!client->isMarkedForDisconnect() && !isInputPaused(*client)){
+			processMessages(*client);
+		}
 	}
 }
 
@@ -342,48 +532,86 @@ void	Server::processDataFromClient(int idx){
  * @param reason: the reason that why remove the user;
  */
 void	Server::removeClient(Client& usr, std::string reason){
-	int	usr_fd = usr.getSocketFd();
-
-	// 1.Remove the user from joined channels
-	for (auto it = channels_.begin(); it != channels_.end(); ){
-		std::shared_ptr<Channel> channel_ptr = it->second;
-
-		if (channel_ptr->isUserInList(usr, USERTYPE::REGULAR)
-			|| channel_ptr->isUserInList(usr, USERTYPE::INVITE)){
-			channel_ptr->removeUser(usr);
-			// After remove the user, if the channel become an empty channel, then
-			// remove it from channels map
-			if (channel_ptr->isEmptyChannel()){ //channel is empty
-				it = channels_.erase(it); // erase returns the next valid iterator
-				Logger::log(Logger::INFO, "Channel is empty, remove it");
-				continue;
-			} else { // channel is not empty
-				// send QUIT information to all other users
-				std::string message = rplQuit(usr.getPrefix(), reason);
-				channel_ptr->notifyChannelUsers(usr, message);
-				Logger::log(Logger::INFO, "Notify channel users that one member left");
-			}
+	int		usr_fd = usr.getSocketFd();
+
+	// 1.Send QUIT information to the users sharing a channel with the user, once
+	// each, then remove the user from joined channels. removeUser() edits the
+	// user's list of channels, walk a copy of it
+	std::vector<Channel*>	joined = usr.getChannels();
+	if (!joined.empty()){
+		notifyNeighbors(usr, rplQuit(usr.getPrefix(), reason));
+		Logger::log(Logger::INFO, "Notify channel users that one member left");
+	}
+	for (Channel* channel : joined){
+		channel->removeUser(usr);
+		// After remove the user, if the channel become an empty channel, then
+		// remove it from channels map
+		if (channel->isEmptyChannel()){ //channel is empty
+			removeChannel(*channel);
 		}
-		++it;
 	}
-	// 2.Remove from epoll container
-	auto it = std::remove_if(events_.begin(), events_.end(),[usr_fd](const epoll_event& ev){
-		return ev.data.fd == usr_fd;
-	});
-	if (it != events_.end()){
-		events_.erase(it, events_.end());
+	// and from the invite lists of the channels it didn't join
+	std::vector<Channel*>	invited = usr.getInvites();
+	for (Channel* channel : invited){
+		channel->removeInviteUser(usr);
 	}
+	// 2.Unregister the fd from the reactor's backend, events of this batch that
+	// are still pending for it are dropped. Clients are only removed by the
+	// reactor that owns them.
+	reactor_->backend_->removeClient(usr_fd);
+	reactor_->timers_.cancel(usr.getTimer());
+	reactor_->flood_timers_.cancel(usr.getFloodTimer());
 
-	// 3.Inform the kernel to remove the file descriptor from the actual epoll monitoring set
-	epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, usr_fd, nullptr);
-
-	// 4. Remove from Clients map
+	// 3. Remove from the client table and the nick index. The Client object
+	// stays valid until the end of the tick, the caller may be running its
+	// command
+	if (usr.isRegistered()){
+		nicks_.erase(foldNick(usr.getNick()));
+	}
     close(usr_fd);
-	clients_.erase(usr_fd);
+	reactor_->clients_.remove(usr);
+	n_user_--;
 	Logger::log(Logger::INFO, "Removing client " + std::to_string(usr_fd) + ": " + reason);
 }
 
 
+/**
+ * @brief Creates a channel with the creator as its operator and registers it
+ * under its folded name. The caller checked that the name is free.
+ */
+std::shared_ptr<Channel>	Server::addChannel(const std::string& channel_name, Client& creator){
+	std::shared_ptr<Channel>	channel = std::make_shared<Channel>(channel_name,
+		CaseMap::fold(channel_name, config_.casemapping), creator);
+	channels_.emplace(channel->getKey(), channel);
+	n_channel_++;
+	return channel;
+}
+
+/**
+ * @brief Send the payload to everyone sharing a channel with cli, but not to
+ * cli itself. A user met in several channels gets it once: every call starts
+ * a new epoch and a user is skipped when its mark already carries it, so
+ * there is no set of recipients to build and clear. In a +u channel the
+ * operators are the only neighbors of a regular member.
+ */
+void	Server::notifyNeighbors(Client& cli, const Payload& payload){
+	uint64_t	epoch = ++fanout_epoch_;
+
+	cli.visit(epoch);
+	for (Channel* channel : cli.getChannels()){
+		bool	operators_only = channel->isHiddenMember(cli); // +u
+		for (const auto& member : channel->getChannelUsers()){
+			if (operators_only && !(member.modes & ChannelMember::OPERATOR)){
+				continue;
+			}
+			Client*	user = getClient(member.client);
+			if (user && user->visit(epoch)){
+				responseToClient(*user, payload);
+			}
+		}
+	}
+}
+
 /**
  * @brief Removes a channel from the server's channel map.
  *
@@ -393,13 +621,14 @@ void	Server::removeClient(Client& usr, std::string reason){
  * The std::shared_ptr<Channel> will automatically delete the Channel object
  * when all references (including the one in the map) are gone.
  *
- * @param channel_name The name of the channel to remove.
+ * @param channel The channel to remove.
  */
-void Server::removeChannel(const std::string& channel_name) {
-	auto it = channels_.find(channel_name);
+void Server::removeChannel(Channel& channel) {
+	auto it = channels_.find(channel.getKey());
 	if (it != channels_.end()) {
+		Logger::log(Logger::INFO, "Channel " + channel.getName() + " has been deleted.");
 		channels_.erase(it); // Triggers destruction if this was the last shared_ptr
-		Logger::log(Logger::INFO, "Channel " + channel_name + " has been deleted.");
+		n_channel_--;
 	}
 }
 
@@ -410,34 +639,32 @@ void Server::removeChannel(const std::string& channel_name) {
  */
 void	Server::executeCommand(Message& msg, Client& cli){
 	COMMANDTYPE	cmd_type = msg.getCommandType();
-	std::string cmd_str_type = msg.getCommandString();
+	std::string_view	cmd_str_type = msg.getCommandString();
 
 	if (cmd_type == INVALID){
 		responseToClient(cli, unknowCommand(cli.getNick(), cmd_str_type));
 		return;
 	}
+	uint8_t	flags = CommandTable::get(cmd_type).flags;
 	// Before the user sends the correct password, he/she can't execute any commands
-	if (cli.getPassword().empty()){
-		if (cmd_type != PASS && cmd_type != CAP && cmd_type != PING && cmd_type != WHOIS){
-			responseToClient(cli, passwdMismatch(cli.getNick()));
-			Logger::log(Logger::WARNING, "User hasn't sent correct password yet, can't execute the command");
-			return;
-		}
+	// but the BEFORE_PASS ones
+	if (cli.getPassword().empty() && !(flags & CommandInfo::BEFORE_PASS)){
+		responseToClient(cli, passwdMismatch(cli.getNick()));
+		Logger::log(Logger::WARNING, "User hasn't sent correct password yet, can't execute the command");
+		return;
 	}
 	// 1.If the client hasn't finished registration, then the user can not operate
-	// the commands except PASS, NICK, USER and QUIT
-	if (!cli.isRegistered() && pre_registration_allowed_commands_.find(cmd_type)
-		== pre_registration_allowed_commands_.end() ){
+	// the commands except the BEFORE_REGISTRATION ones (PASS, NICK, USER, QUIT...)
+	if (!cli.isRegistered() && !(flags & CommandInfo::BEFORE_REGISTRATION)){
 		Logger::log(Logger::WARNING, "Unregistered client can't execute the command");
 		responseToClient(cli, NotRegistered(cmd_str_type));
 		return;
 	}
 	// 2. Find the matched command, then call that command; otherwise, response
 	// unknowncommand error
-	std::unordered_map<COMMANDTYPE, executeFunc>::const_iterator it =
-		execute_map_.find(cmd_type);
-	if (it != execute_map_.end()){
-		(this->*it->second)(msg, cli);
+	executeFunc	execute = execute_table_[cmd_type];
+	if (execute){
+		(this->*execute)(msg, cli);
 	} else {
 		responseToClient(cli, unknowCommand(cli.getNick(), cmd_str_type));
 	}
@@ -446,20 +673,349 @@ void	Server::executeCommand(Message& msg, Client& cli){
 /**
  * @brief Send response message to client
  *
+ * The response is put into the client's send queue. When it is written depends
+ * on the flush policy: right away with IMMEDIATE (if nothing was waiting already),
+ * otherwise at the end of the current event loop iteration together with the
+ * other replies of the tick. Whatever the socket can't take stays queued and
+ * write readiness is watched until the queue has drained. A client whose queue is full
+ * is disconnected after the current batch of events.
+ * A client owned by another reactor gets the response through that reactor's
+ * inbox, only the owner thread writes to a socket.
+ *
  * @param cli: the response message receiver
  * @param repsonse: the reponse message
  *
- * @return bytes written or throw error(negative value)
+ * @return bytes queued, or -1 when the client's send queue is full
  */
-int	Server::responseToClient(Client& cli, const std::string& response){
-	int	n_bytes = send(cli.getSocketFd(), response.c_str(), response.length(), MSG_DONTWAIT);
-	if (n_bytes < 0){
-		Logger::log(Logger::WARNING, "Failed to send data to user " + cli.getNick() +
-		": " + response);
+int	Server::responseToClient(Client& cli, std::string response){
+	return responseToClient(cli, makePayload(std::move(response)));
+}
+
+/**
+ * @brief responseToClient() for bytes that go to several clients: serialize
+ * the message once with makePayload(), every recipient queues a reference.
+ * A DROPPABLE payload is skipped for a lagged client under SENDQPOLICY::DROP.
+ */
+int	Server::responseToClient(Client& cli, const Payload& payload, TRAFFIC traffic){
+	if (cli.getReactorId() != reactor_->getId()){
+		server_->reactors_[cli.getReactorId()]->post({cli.getHandle(), payload, traffic});
+		return (payload->length());
+	}
+	return server_->queueToClient(cli, payload, traffic);
+}
+
+/**
+ * @brief responseToClient() for a client of the calling thread's reactor.
+ * Crossing a watermark is logged once, not per message: in a broadcast to a
+ * slow consumer this runs for every line of the channel.
+ */
+int	Server::queueToClient(Client& cli, const Payload& payload, TRAFFIC traffic){
+	if (cli.isMarkedForDisconnect()){
+		return 0;
+	}
+	if (traffic == TRAFFIC::DROPPABLE && cli.isLagged() && config_.sendq_policy == SENDQPOLICY::DROP){
+		cli.countDropped();
+		return 0;
+	}
+	bool	was_empty = !cli.hasPendingOutput();
+	if (!cli.queueResponse(payload)){
+		Logger::log(Logger::WARNING, "SendQ exceeded for user " + cli.getNick());
+		scheduleDisconnect(cli, "SendQ exceeded");
+		return -1;
+	}
+	if (!cli.isLagged() && cli.getSendQueue().size() > config_.sendq_high){
+		onSendqHigh(cli);
+		if (cli.isMarkedForDisconnect()){
+			return -1;
+		}
+	}
+	if (Logger::isEnabled(Logger::DEBUG)){
+		Logger::log(Logger::DEBUG, "Queued for "+ cli.getNick() + ": " + *payload);
+	}
+	if (config_.flush_policy == FLUSHPOLICY::IMMEDIATE){
+		if (was_empty){
+			flushClient(cli);
+		}
 	} else {
-		Logger::log(Logger::DEBUG, "Sent successfully "+ cli.getNick() + ": " + response);
+		scheduleFlush(cli);
+	}
+	return (payload->length());
+}
+
+/**
+ * @brief Hand the client's send queue to the backend, then watch or stop
+ * watching for writability depending on what is left.
+ */
+void	Server::flushClient(Client& cli){
+	if (cli.isMarkedForDisconnect()){
+		return;
+	}
+	if (reactor_->backend_->send(cli.getSocketFd(), cli.getSendQueue()) < 0){
+		Logger::log(Logger::WARNING, "Failed to send data to user " + cli.getNick() +
+			": " + strerror(errno));
+		scheduleDisconnect(cli, "Write error");
+		return;
+	}
+	if (cli.isLagged() && cli.getSendQueue().size() <= config_.sendq_low){
+		onSendqLow(cli);
+	}
+	updateClientEvents(cli);
+}
+
+/**
+ * @brief The client's send queue passed the high watermark: it reads slower
+ * than the server writes to it. Apply the sendq policy.
+ */
+void	Server::onSendqHigh(Client& cli){
+	size_t	queued = cli.getSendQueue().size();
+	if (config_.sendq_policy == SENDQPOLICY::DISCONNECT){
+		Logger::log(Logger::WARNING, "SendQ exceeded for user " + cli.getNick()
+			+ " (" + std::to_string(queued) + " bytes)");
+		scheduleDisconnect(cli, "SendQ exceeded");
+		return;
+	}
+	cli.setLagged(true);
+	Logger::log(Logger::WARNING, "User " + cli.getNick() + " is lagging, "
+		+ std::to_string(queued) + " bytes queued");
+	if (config_.sendq_policy == SENDQPOLICY::LAG){
+		updateClientEvents(cli);
+	}
+}
+
+/**
+ * @brief The lagged client has drained its queue under the low watermark.
+ */
+void	Server::onSendqLow(Client& cli){
+	cli.setLagged(false);
+	size_t	n_dropped = cli.takeDropped();
+	Logger::log(Logger::INFO, "User " + cli.getNick() + " caught up"
+		+ (n_dropped ? ", " + std::to_string(n_dropped) + " messages dropped" : ""));
+	// under LAG its input waited, give it a turn
+	if (!isInputPaused(cli) && cli.hasNextMessage()){
+		scheduleReady(cli);
+	}
+}
+
+/**
+ * @brief Whether the client's input is left alone for now: it is throttled by
+ * the flood control, or lagging under SENDQPOLICY::LAG.
+ */
+bool	Server::isInputPaused(const Client& cli) const{
+	return cli.isThrottled() || (cli.isLagged() && config_.sendq_policy == SENDQPOLICY::LAG);
+}
+
+/**
+ * @brief Remember the client to be flushed at the end of the tick. With the CORK
+ * policy the socket is corked on the first reply, so the kernel holds partial
+ * packets until the socket is uncorked flush_delay_us later.
+ */
+void	Server::scheduleFlush(Client& cli){
+	if (!cli.isInFlushList()){
+		cli.setInFlushList(true);
+		reactor_->flush_list_.push_back(cli.getSocketFd());
+	}
+	if (config_.flush_policy == FLUSHPOLICY::CORK && !cli.isCorked()){
+		int	on = 1;
+		if (setsockopt(cli.getSocketFd(), IPPROTO_TCP, TCP_CORK, &on, sizeof(on)) == 0){
+			cli.setCorked(true);
+			reactor_->corked_clients_.emplace_back(cli.getSocketFd(), std::chrono::steady_clock::now()
+				+ std::chrono::microseconds(config_.flush_delay_us));
+		}
+	}
+}
+
+/**
+ * @brief Write the replies queued during this tick, one writev() per client.
+ */
+void	Server::flushPendingClients(){
+	Reactor&	reactor = *reactor_;
+	for (size_t i = 0; i < reactor.flush_list_.size(); i++){
+		Client*	client = reactor.clients_.get(reactor.flush_list_[i]);
+		if (!client || !client->isInFlushList()){
+			continue;
+		}
+		client->setInFlushList(false);
+		// while watching for writability the socket is full (or a send is in flight),
+		// the queue drains from onWritable()
+		if (!client->isWatchingWrite()){
+			flushClient(*client);
+		}
+	}
+	reactor.flush_list_.clear();
+}
+
+/**
+ * @brief Uncork the sockets whose delay has passed, that pushes the held back
+ * partial packets out.
+ */
+void	Server::uncorkExpiredClients(){
+	Reactor&	reactor = *reactor_;
+	if (reactor.corked_clients_.empty()){
+		return;
+	}
+	auto	now = std::chrono::steady_clock::now();
+	size_t	kept = 0;
+	for (size_t i = 0; i < reactor.corked_clients_.size(); i++){
+		if (reactor.corked_clients_[i].second > now){
+			reactor.corked_clients_[kept++] = reactor.corked_clients_[i];
+			continue;
+		}
+		Client*	client = reactor.clients_.get(reactor.corked_clients_[i].first);
+		if (client && client->isCorked()){
+			int	off = 0;
+			setsockopt(client->getSocketFd(), IPPROTO_TCP, TCP_CORK, &off, sizeof(off));
+			client->setCorked(false);
+		}
+	}
+	reactor.corked_clients_.resize(kept);
+}
+
+/**
+ * @brief Timeout for the backend wait(): don't block while there is work left for the
+ * end of the tick or clients with a backlog, wake up when the earliest corked socket is due.
+ */
+int	Server::computeWaitTimeout() const{
+	Reactor&	reactor = *reactor_;
+	if (!reactor.pending_disconnects_.empty() || !reactor.flush_list_.empty()
+		|| !reactor.ready_list_.empty()){
+		return 0;
+	}
+	int	timeout = reactor.timers_.msUntilNextExpiry();
+	int	flood_timeout = reactor.flood_timers_.msUntilNextExpiry();
+	if (timeout < 0 || (flood_timeout >= 0 && flood_timeout < timeout)){
+		timeout = flood_timeout;
+	}
+	if (reactor.corked_clients_.empty()){
+		return timeout;
+	}
+	auto	earliest = reactor.corked_clients_.front().second;
+	for (const auto& [fd, deadline] : reactor.corked_clients_){
+		earliest = std::min(earliest, deadline);
+	}
+	auto	left = std::chrono::duration_cast<std::chrono::microseconds>(
+		earliest - std::chrono::steady_clock::now()).count();
+	if (left <= 0){
+		return 0;
+	}
+	// round up, the wait only has millisecond resolution
+	int	cork_timeout = static_cast<int>((left + 999) / 1000);
+	return timeout < 0 ? cork_timeout : std::min(timeout, cork_timeout);
+}
+
+/**
+ * @brief (Re)arm the client's timer for its current state. An active client is
+ * due when it has been silent for ping_interval, or idle for idle_timeout.
+ */
+void	Server::armClientTimer(Client& cli){
+	using std::chrono::seconds;
+	using std::chrono::milliseconds;
+	using std::chrono::duration_cast;
+
+	TimerWheel&	timers = reactor_->timers_;
+	switch (cli.getConnState()){
+		case CONNSTATE::REGISTERING:
+			timers.arm(cli.getTimer(), seconds(config_.register_timeout));
+			return;
+		case CONNSTATE::AWAIT_PONG:
+			timers.arm(cli.getTimer(), seconds(config_.ping_timeout));
+			return;
+		case CONNSTATE::ACTIVE:
+			break;
+	}
+	auto	now = std::chrono::steady_clock::now();
+	auto	due = cli.getLastActivity() + seconds(config_.ping_interval);
+	if (config_.idle_timeout > 0){
+		due = std::min(due, cli.getLastCommand() + seconds(config_.idle_timeout));
+	}
+	timers.arm(cli.getTimer(), std::max(duration_cast<milliseconds>(due - now), milliseconds(0)));
+}
+
+/**
+ * @brief The client's timer expired. Lines received in the meantime only moved
+ * the timestamps, so an active client is checked here and re-armed if it
+ * turned out to be alive.
+ */
+void	Server::onClientTimer(int fd){
+	using std::chrono::seconds;
+
+	Client*	client = reactor_->clients_.get(fd);
+	if (!client || client->isMarkedForDisconnect()){
+		return;
 	}
-	return (n_bytes);
+	Client&	cli = *client;
+	auto	now = std::chrono::steady_clock::now();
+	switch (cli.getConnState()){
+		case CONNSTATE::REGISTERING:
+			scheduleDisconnect(cli, "Registration timeout");
+			return;
+		case CONNSTATE::AWAIT_PONG:
+			// nothing arrived since the PING
+			if (cli.getLastActivity() <= cli.getPingSent()){
+				scheduleDisconnect(cli, "Ping timeout: " + std::to_string(config_.ping_timeout)
+					+ " seconds");
+				return;
+			}
+			cli.setConnState(CONNSTATE::ACTIVE);
+			break;
+		case CONNSTATE::ACTIVE:
+			if (config_.idle_timeout > 0
+				&& now - cli.getLastCommand() >= seconds(config_.idle_timeout)){
+				scheduleDisconnect(cli, "Idle timeout");
+				return;
+			}
+			if (now - cli.getLastActivity() >= seconds(config_.ping_interval)){
+				responseToClient(cli, "PING :" + std::string(SERVER) + CRLF);
+				cli.setPingSent(now);
+				cli.setConnState(CONNSTATE::AWAIT_PONG);
+			}
+			break;
+	}
+	armClientTimer(cli);
+}
+
+/**
+ * @brief Write readiness is only watched while the client has unsent data.
+ * Whatever the backend couldn't take yet goes out from onWritable(). A
+ * paused client isn't read.
+ */
+void	Server::updateClientEvents(Client& cli){
+	bool	want_write = cli.hasPendingOutput();
+	bool	want_read = !isInputPaused(cli);
+	if (want_write == cli.isWatchingWrite() && want_read == cli.isWatchingRead()){
+		return;
+	}
+	reactor_->backend_->watch(cli.getSocketFd(), want_read, want_write);
+	cli.setWatchingWrite(want_write);
+	cli.setWatchingRead(want_read);
+}
+
+/**
+ * @brief Remember a client to be removed once the current batch of events is
+ * handled. Removing right away isn't safe from inside a channel broadcast.
+ */
+void	Server::scheduleDisconnect(Client& cli, const std::string& reason){
+	if (cli.isMarkedForDisconnect()){
+		return;
+	}
+	cli.markForDisconnect(reason);
+	reactor_->pending_disconnects_.push_back(cli.getSocketFd());
+}
+
+void	Server::disconnectMarkedClients(){
+	Reactor&	reactor = *reactor_;
+	if (reactor.pending_disconnects_.empty()){
+		return;
+	}
+	std::lock_guard<std::mutex>	lock(state_mutex_);
+	// removeClient() may schedule more clients (broadcasting QUIT), so don't use
+	// iterators here
+	for (size_t i = 0; i < reactor.pending_disconnects_.size(); i++){
+		Client*	client = reactor.clients_.get(reactor.pending_disconnects_[i]);
+		if (client && client->isMarkedForDisconnect()){
+			removeClient(*client, client->getDisconnectReason());
+		}
+	}
+	reactor.pending_disconnects_.clear();
 }
 
 /**
@@ -468,54 +1024,67 @@ int	Server::responseToClient(Client& cli, const std::string& response){
  */
 std::string Server::getChannelsOfUser(Client& client){
 	std::string result;
-	for (const auto& [channelName, channelPtr] : channels_){
-		if (channelPtr && channelPtr->isChannelUser(client)){
-			if (!result.empty())
-				result += " ";
-			result += channelName;
-		}
+	for (Channel* channel : client.getChannels()){
+		if (!result.empty())
+			result += " ";
+		result += channel->getName();
 	}
 	return result;
 }
 
 /**
- * @brief Finds a client by their nickname.
+ * @brief The client a handle names, nullptr once it is gone. Reading another
+ * reactor's table needs state_mutex_, like all the shared state.
+ */
+Client*	Server::getClient(const ClientHandle& handle){
+	if (handle.reactor >= server_->reactors_.size()){
+		return nullptr;
+	}
+	return server_->reactors_[handle.reactor]->clients_.get(handle);
+}
+
+/**
+ * @brief Finds a registered client by their nickname, the case of the letters
+ * doesn't matter (see CASEMAPPING).
  *
  * @param nick: The nickname of the client to search for.
  * @return Pointer to the Client if found, nullptr otherwise.
  */
 // we can't return a reference, becasue it might be a nullptr
- std::shared_ptr<Client>	Server::getUserByNick(const std::string& user_nick) const{
-	for (auto& [fd, user] : clients_){
-		if (user && user->getNick() == user_nick){
-			return user;
-		}
+Client*	Server::getUserByNick(std::string_view user_nick) const{
+	auto	it = nicks_.find(foldNick(user_nick));
+	if (it == nicks_.end()){
+		return nullptr;
 	}
-	return nullptr;
+	return it->second;
 }
 
 /**
- * @brief Return a channel object by the given channel name.
+ * @brief Return a channel object by the given channel name, the case of the
+ * letters doesn't matter (see CASEMAPPING).
  *
  * @param channel_name: channel name to search for.
  * @return Pointer to the channel if found, nullptr otherwise.
  */
 // we can't return a reference, becasue it might be a nullptr
-std::shared_ptr<Channel>	Server::getChannelByName(const std::string& channel_name) const{
-	for (const auto& [name, channelPtr] : channels_){
-		if (name == channel_name){
-			return channelPtr;
-		}
+std::shared_ptr<Channel>	Server::getChannelByName(std::string_view channel_name) const{
+	// one hash lookup, folding into the scratch buffer doesn't allocate
+	CaseMap::fold(channel_name, config_.casemapping, fold_buffer_);
+	auto	it = channels_.find(fold_buffer_);
+	if (it == channels_.end()){
+		return nullptr;
 	}
-	return nullptr;
+	return it->second;
 }
 
 #if 0
 // for testing only
 void	Server::printUsers() const{
 	std::cout << "All the users on this server:\n";
-	for (const auto& [fd, user_ptr] : clients_){
-		std::cout << "	fd=" << fd << ", nick=" << user_ptr->getNick() << std::endl;
+	for (const auto& reactor : reactors_){
+		reactor->clients_.forEach([](Client& user){
+			std::cout << "	fd=" << user.getSocketFd() << ", nick=" << user.getNick() << std::endl;
+		});
 	}
 }
 
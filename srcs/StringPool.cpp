@@ -0,0 +1,38 @@
+#include "StringPool.hpp"
+#include <algorithm>
+
+// Entries the pool can hold before the first sweep
+#define STRINGPOOL_MIN_SWEEP (64)
+
+StringPool::StringPool() : next_sweep_(STRINGPOOL_MIN_SWEEP){}
+
+Interned	StringPool::intern(std::string_view str){
+	auto	it = strings_.find(str);
+	if (it != strings_.end()){
+		return it->second;
+	}
+	if (strings_.size() >= next_sweep_){
+		sweep();
+	}
+	Interned	copy = std::make_shared<const std::string>(str);
+	strings_.emplace(*copy, copy);
+	return copy;
+}
+
+size_t	StringPool::size() const{
+	return strings_.size();
+}
+
+/**
+ * @brief Drop the strings only the pool still holds.
+ */
+void	StringPool::sweep(){
+	for (auto it = strings_.begin(); it != strings_.end();){
+		if (it->second.use_count() == 1){
+			it = strings_.erase(it);
+		} else{
+			++it;
+		}
+	}
+	next_sweep_ = std::max<size_t>(STRINGPOOL_MIN_SWEEP, strings_.size() * 2);
+}
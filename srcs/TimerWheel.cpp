@@ -0,0 +1,122 @@
+#include "TimerWheel.hpp"
+
+TimerWheel::Timer::Timer() : prev(nullptr), next(nullptr), expires(0), fd(-1){}
+
+bool	TimerWheel::Timer::isArmed() const{
+	return next != nullptr;
+}
+
+TimerWheel::TimerWheel()
+	: next_tick_(0), n_timers_(0), origin_(std::chrono::steady_clock::now()){
+	for (auto& level : slots_){
+		for (auto& head : level){
+			head.next = head.prev = &head;
+		}
+	}
+}
+
+uint64_t	TimerWheel::currentTick() const{
+	auto	elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - origin_);
+	return elapsed.count() / TIMER_TICK_MS;
+}
+
+/**
+ * @brief Arm the timer, or move it if it is armed already. It fires up to one
+ * tick late.
+ */
+void	TimerWheel::arm(Timer& timer, std::chrono::milliseconds delay){
+	if (timer.isArmed()){
+		unlink(timer);
+	}
+	else{
+		// an empty wheel isn't advanced, catch up without walking the idle ticks
+		if (n_timers_ == 0){
+			next_tick_ = currentTick();
+		}
+		n_timers_++;
+	}
+	// round the deadline up to a tick boundary, a timer never fires early
+	auto	elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - origin_);
+	timer.expires = (elapsed.count() + delay.count() + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+	insert(timer);
+}
+
+void	TimerWheel::cancel(Timer& timer){
+	if (!timer.isArmed()){
+		return;
+	}
+	unlink(timer);
+	n_timers_--;
+}
+
+bool	TimerWheel::empty() const{
+	return n_timers_ == 0;
+}
+
+/**
+ * @brief Milliseconds until advance() has something to do: the first non
+ * empty slot of level 0, or the next cascade. -1 when no timer is armed.
+ */
+int	TimerWheel::msUntilNextExpiry() const{
+	if (n_timers_ == 0){
+		return -1;
+	}
+	// on a multiple of SLOTS the cascade is due, level 0 doesn't tell anything yet
+	uint64_t	tick = next_tick_;
+	while (tick & SLOT_MASK){
+		const Timer&	head = slots_[0][tick & SLOT_MASK];
+		if (head.next != &head){
+			break;
+		}
+		tick++;
+	}
+	auto	elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - origin_);
+	long long	due = static_cast<long long>(tick) * TIMER_TICK_MS - elapsed.count();
+	return due > 0 ? static_cast<int>(due) : 0;
+}
+
+/**
+ * @brief Put the timer in the slot of the lowest level whose span covers its
+ * distance from next_tick_. Timers beyond the last level are clamped to it.
+ */
+void	TimerWheel::insert(Timer& timer){
+	if (timer.expires < next_tick_){
+		timer.expires = next_tick_;
+	}
+	uint64_t	delta = timer.expires - next_tick_;
+	int			level = 0;
+	while (level < LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1)))){
+		level++;
+	}
+	if (delta >= (uint64_t(1) << (SLOT_BITS * LEVELS))){
+		timer.expires = next_tick_ + (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+	}
+	Timer&	head = slots_[level][(timer.expires >> (SLOT_BITS * level)) & SLOT_MASK];
+	timer.prev = head.prev;
+	timer.next = &head;
+	head.prev->next = &timer;
+	head.prev = &timer;
+}
+
+/**
+ * @brief Redistribute the current slot of this level over the levels below.
+ */
+bool	TimerWheel::cascade(int level){
+	int		index = (next_tick_ >> (SLOT_BITS * level)) & SLOT_MASK;
+	Timer&	head = slots_[level][index];
+	while (head.next != &head){
+		Timer*	timer = head.next;
+		unlink(*timer);
+		insert(*timer);
+	}
+	return index != 0;
+}
+
+void	TimerWheel::unlink(Timer& timer){
+	timer.prev->next = timer.next;
+	timer.next->prev = timer.prev;
+	timer.prev = timer.next = nullptr;
+}
@@ -0,0 +1,39 @@
+#include "TokenBucket.hpp"
+#include <algorithm>
+#include <cmath>
+
+TokenBucket::TokenBucket() : tokens_(0), last_refill_(){}
+
+/**
+ * @brief Add what was earned since the last refill. A new client starts with
+ * a full bucket.
+ */
+void	TokenBucket::refill(double rate, double burst, std::chrono::steady_clock::time_point now){
+	if (last_refill_ == std::chrono::steady_clock::time_point()){
+		tokens_ = burst;
+	} else {
+		std::chrono::duration<double>	elapsed = now - last_refill_;
+		tokens_ = std::min(burst, tokens_ + elapsed.count() * rate);
+	}
+	last_refill_ = now;
+}
+
+bool	TokenBucket::hasTokens() const{
+	return tokens_ > 0;
+}
+
+bool	TokenBucket::take(int cost){
+	tokens_ -= cost;
+	return tokens_ < 0;
+}
+
+/**
+ * @brief How long until hasTokens() is true again, counted from the last refill.
+ */
+std::chrono::milliseconds	TokenBucket::timeUntilTokens(double rate) const{
+	if (tokens_ > 0 || rate <= 0){
+		return std::chrono::milliseconds(0);
+	}
+	// a little more than the debt, tokens_ has to become positive
+	return std::chrono::milliseconds(static_cast<long long>(std::ceil(-tokens_ / rate * 1000)) + 1);
+}
@@ -0,0 +1,477 @@
+#include "UringBackend.hpp"
+#include "SendQueue.hpp"
+#include "Logger.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+// user_data of the per fd operations: generation | fd | OPTYPE
+static uint64_t	encode(int type, int fd, uint32_t generation){
+	return (static_cast<uint64_t>(generation) << 32)
+		| (static_cast<uint64_t>(fd) << 3) | static_cast<uint64_t>(type);
+}
+
+UringBackend::UringBackend() : ring_fd_(-1), sq_ring_(MAP_FAILED), sq_ring_size_(0),
+sq_head_(nullptr), sq_tail_(nullptr), sq_mask_(nullptr), sq_array_(nullptr),
+sqes_(static_cast<struct io_uring_sqe*>(MAP_FAILED)), sqes_size_(0), sq_entries_(0),
+sq_local_tail_(0), cq_ring_(MAP_FAILED), cq_ring_size_(0), cq_head_(nullptr),
+cq_tail_(nullptr), cq_mask_(nullptr), cqes_(nullptr),
+buf_ring_(static_cast<struct io_uring_buf_ring*>(MAP_FAILED)), buf_ring_size_(0),
+buffers_(nullptr), buf_local_tail_(0), listen_fd_(-1), wake_fd_(-1), n_sends_(0){
+	struct io_uring_params	params{};
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = URING_ENTRIES * 4;
+	ring_fd_ = syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+	if (ring_fd_ < 0){
+		throw std::runtime_error("io_uring_setup: " + std::string(strerror(errno)));
+	}
+	unsigned	required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+	if ((params.features & required) != required){
+		cleanup();
+		throw std::runtime_error("io_uring: the kernel is too old");
+	}
+
+	// 1. map the rings, the SQ and CQ rings share one mapping
+	sq_ring_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+		params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+	sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring_fd_, IORING_OFF_SQ_RING);
+	sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+	sqes_ = static_cast<struct io_uring_sqe*>(mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+	if (sq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED){
+		cleanup();
+		throw std::runtime_error("io_uring: mmap failed");
+	}
+	cq_ring_ = sq_ring_;
+	char*	sq = static_cast<char*>(sq_ring_);
+	sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	sq_entries_ = params.sq_entries;
+	sq_local_tail_ = *sq_tail_;
+	char*	cq = static_cast<char*>(cq_ring_);
+	cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+	// 2. register the provided buffer ring the multishot recvs take buffers from
+	buf_ring_size_ = URING_RECV_BUFFERS * sizeof(struct io_uring_buf);
+	buf_ring_ = static_cast<struct io_uring_buf_ring*>(mmap(nullptr, buf_ring_size_,
+		PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	if (buf_ring_ == MAP_FAILED){
+		cleanup();
+		throw std::runtime_error("io_uring: mmap failed");
+	}
+	buffers_ = new char[URING_RECV_BUFFERS * URING_RECV_BUFFER_SIZE];
+	struct io_uring_buf_reg	reg{};
+	reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+	reg.ring_entries = URING_RECV_BUFFERS;
+	reg.bgid = BUFFER_GROUP;
+	if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0){
+		std::string	error = strerror(errno);
+		cleanup();
+		throw std::runtime_error("io_uring: provided buffer ring: " + error);
+	}
+	for (unsigned i = 0; i < URING_RECV_BUFFERS; i++){
+		recycleBuffer(i);
+	}
+	__atomic_store_n(&buf_ring_->tail, buf_local_tail_, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Sends still in flight point at their SendOp buffers, cancel them and
+ * wait a moment for the completions before the buffers are freed.
+ */
+UringBackend::~UringBackend(){
+	if (n_sends_ > 0){
+		struct io_uring_sqe*	sqe = getSqe();
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->fd = -1;
+		sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+		sqe->user_data = OP_CANCEL;
+		publishSqes();
+
+		struct __kernel_timespec		ts{};
+		struct io_uring_getevents_arg	arg{};
+		ts.tv_nsec = 100 * 1000 * 1000;
+		arg.ts = reinterpret_cast<uint64_t>(&ts);
+		while (n_sends_ > 0){
+			if (enter(1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)) < 0
+				&& errno != EINTR){
+				break;
+			}
+			unsigned	head = *cq_head_;
+			while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)){
+				uint64_t	user_data = cqes_[head & *cq_mask_].user_data;
+				if ((user_data & 7) == OP_SEND){
+					delete reinterpret_cast<SendOp*>(user_data & ~7ULL);
+					n_sends_--;
+				}
+				head++;
+			}
+			__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+		}
+	}
+	cleanup();
+}
+
+void	UringBackend::cleanup(){
+	if (sqes_ != MAP_FAILED){
+		munmap(sqes_, sqes_size_);
+	}
+	if (sq_ring_ != MAP_FAILED){
+		munmap(sq_ring_, sq_ring_size_);
+	}
+	if (ring_fd_ != -1){
+		close(ring_fd_);
+	}
+	// the ring is closed, the kernel doesn't use the receive buffers anymore
+	if (buf_ring_ != MAP_FAILED){
+		munmap(buf_ring_, buf_ring_size_);
+	}
+	delete[] buffers_;
+	sqes_ = static_cast<struct io_uring_sqe*>(MAP_FAILED);
+	sq_ring_ = MAP_FAILED;
+	cq_ring_ = MAP_FAILED;
+	buf_ring_ = static_cast<struct io_uring_buf_ring*>(MAP_FAILED);
+	buffers_ = nullptr;
+	ring_fd_ = -1;
+}
+
+const char*	UringBackend::getName() const{
+	return "io_uring";
+}
+
+void	UringBackend::addListener(int fd){
+	listen_fd_ = fd;
+	armAccept();
+}
+
+void	UringBackend::addWakeUpFd(int fd){
+	wake_fd_ = fd;
+	armWakeUp();
+}
+
+void	UringBackend::addClient(int fd){
+	FdState&	state = fdState(fd);
+	state.send_in_flight = false;
+	state.read_paused = false;
+	armRecv(fd);
+}
+
+/**
+ * @brief Forget the client: completions that still arrive for it carry the old
+ * generation and are dropped. The cancel goes to the kernel right away, the
+ * caller closes the fd next and a cancel by fd needs the fd to be open.
+ */
+void	UringBackend::removeClient(int fd){
+	FdState&	state = fdState(fd);
+	state.generation++;
+	state.send_in_flight = false;
+	state.recv_armed = false;
+
+	struct io_uring_sqe*	sqe = getSqe();
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = fd;
+	sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+	sqe->user_data = OP_CANCEL;
+	publishSqes();
+	if (enter(0, 0, nullptr, 0) < 0){
+		Logger::log(Logger::WARNING, "io_uring_enter: " + std::string(strerror(errno)));
+	}
+}
+
+/**
+ * @brief Take up to SENDQ_IOV_BATCH payloads off the queue into a send
+ * operation, no bytes are copied. While a send is in flight nothing more is
+ * taken, the rest follows when it completes (onWritable()).
+ */
+ssize_t	UringBackend::send(int fd, SendQueue& queue){
+	FdState&	state = fdState(fd);
+	if (state.send_in_flight || queue.empty()){
+		return 0;
+	}
+	SendOp*	op = new SendOp();
+	size_t	n_bytes;
+	op->fd = fd;
+	op->generation = state.generation;
+	op->n_iov = queue.gather(op->iov, SENDQ_IOV_BATCH, n_bytes, op->refs);
+	op->first_iov = 0;
+	queue.consume(n_bytes);
+	state.send_in_flight = true;
+	n_sends_++;
+	submitSend(op);
+	return n_bytes;
+}
+
+/**
+ * @brief A completing send reports onWritable() by itself, only reading needs
+ * work: pausing cancels the multishot recv, resuming arms it again. Data the
+ * recv already picked up before the cancel is still reported.
+ */
+void	UringBackend::watch(int fd, bool read, bool write){
+	(void)write;
+	FdState&	state = fdState(fd);
+	if (state.read_paused == !read){
+		return;
+	}
+	state.read_paused = !read;
+	if (read){
+		// still armed when the cancel hasn't completed yet, that re-arms it
+		if (!state.recv_armed){
+			armRecv(fd);
+		}
+		return;
+	}
+	if (state.recv_armed){
+		struct io_uring_sqe*	sqe = getSqe();
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->addr = encode(OP_RECV, fd, state.generation);
+		sqe->user_data = OP_CANCEL;
+	}
+}
+
+/**
+ * @brief Submit everything prepared since the last call and wait for at least
+ * one completion (or the timeout), then dispatch all the completions.
+ */
+int	UringBackend::wait(int timeout_ms, IoHandler& handler){
+	struct __kernel_timespec		ts{};
+	struct io_uring_getevents_arg	arg{};
+	unsigned						min_complete = 1;
+
+	if (timeout_ms >= 0){
+		ts.tv_sec = timeout_ms / 1000;
+		ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+		arg.ts = reinterpret_cast<uint64_t>(&ts);
+	}
+	if (timeout_ms == 0 || *cq_head_ != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)){
+		min_complete = 0;
+	}
+	publishSqes();
+	if (enter(min_complete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)) < 0){
+		// ETIME: timeout, EBUSY: completions are waiting to be reaped
+		if (errno != EINTR && errno != ETIME && errno != EBUSY && errno != EAGAIN){
+			throw std::runtime_error("Error: io_uring_enter: " + std::string(strerror(errno)));
+		}
+	}
+	int			n = 0;
+	unsigned	head = *cq_head_;
+	while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)){
+		struct io_uring_cqe	cqe = cqes_[head & *cq_mask_];
+		// release the slot before the handler runs, it may throw
+		__atomic_store_n(cq_head_, ++head, __ATOMIC_RELEASE);
+		handleCompletion(cqe, handler);
+		n++;
+	}
+	__atomic_store_n(&buf_ring_->tail, buf_local_tail_, __ATOMIC_RELEASE);
+	return n;
+}
+
+void	UringBackend::handleCompletion(const struct io_uring_cqe& cqe, IoHandler& handler){
+	int		type = cqe.user_data & 7;
+	bool	more = cqe.flags & IORING_CQE_F_MORE;
+
+	if (type == OP_SEND){
+		SendOp*	op = reinterpret_cast<SendOp*>(cqe.user_data & ~7ULL);
+		int		fd = op->fd;
+		if (op->generation != fdState(fd).generation){
+			delete op;
+			n_sends_--;
+			return;
+		}
+		if (cqe.res >= 0){
+			// drop what was sent, a short send goes again with the rest
+			size_t	sent = cqe.res;
+			while (op->first_iov < op->n_iov && sent >= op->iov[op->first_iov].iov_len){
+				sent -= op->iov[op->first_iov].iov_len;
+				op->refs[op->first_iov].reset();
+				op->first_iov++;
+			}
+			if (op->first_iov < op->n_iov){
+				op->iov[op->first_iov].iov_base = static_cast<char*>(op->iov[op->first_iov].iov_base) + sent;
+				op->iov[op->first_iov].iov_len -= sent;
+				submitSend(op);
+				return;
+			}
+		}
+		delete op;
+		n_sends_--;
+		fdState(fd).send_in_flight = false;
+		if (cqe.res < 0){
+			handler.onClose(fd);
+		} else {
+			handler.onWritable(fd);
+		}
+		return;
+	}
+	if (type == OP_ACCEPT){
+		if (cqe.res >= 0){
+			handler.onAccept(cqe.res);
+		} else if (cqe.res != -ECANCELED){
+			Logger::log(Logger::WARNING, "accept failed: " + std::string(strerror(-cqe.res)));
+		}
+		if (!more){
+			armAccept();
+		}
+		return;
+	}
+	if (type == OP_WAKEUP){
+		if (cqe.res >= 0){
+			handler.onWakeUp();
+		}
+		if (!more){
+			armWakeUp();
+		}
+		return;
+	}
+	if (type != OP_RECV){
+		return; // OP_CANCEL
+	}
+	int			fd = (cqe.user_data >> 3) & 0x1fffffff;
+	uint32_t	generation = cqe.user_data >> 32;
+	bool		has_buffer = cqe.flags & IORING_CQE_F_BUFFER;
+	uint16_t	buffer_id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+	// the client was removed, the buffer still has to go back to the ring
+	if (fdState(fd).generation != generation){
+		if (has_buffer){
+			recycleBuffer(buffer_id);
+		}
+		return;
+	}
+	if (cqe.res > 0){
+		handler.onData(fd, buffers_ + buffer_id * URING_RECV_BUFFER_SIZE, cqe.res);
+		recycleBuffer(buffer_id);
+		if (!more && fdState(fd).generation == generation){
+			rearmRecv(fd);
+		}
+		return;
+	}
+	if (has_buffer){
+		recycleBuffer(buffer_id);
+	}
+	// out of receive buffers for a moment, they come back during this batch;
+	// or cancelled by watch()
+	if (cqe.res == -ENOBUFS || cqe.res == -ECANCELED){
+		rearmRecv(fd);
+		return;
+	}
+	// 0: the peer closed the connection, < 0: socket error
+	handler.onClose(fd);
+}
+
+/**
+ * @brief Next free SQE. When the SQ is full the prepared entries are submitted
+ * first.
+ */
+struct io_uring_sqe*	UringBackend::getSqe(){
+	if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_){
+		publishSqes();
+		if (enter(0, 0, nullptr, 0) < 0 && errno != EBUSY && errno != EAGAIN){
+			throw std::runtime_error("Error: io_uring_enter: " + std::string(strerror(errno)));
+		}
+		if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_){
+			throw std::runtime_error("Error: io_uring submission queue is full");
+		}
+	}
+	unsigned				index = sq_local_tail_ & *sq_mask_;
+	struct io_uring_sqe*	sqe = &sqes_[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sq_array_[index] = index;
+	sq_local_tail_++;
+	return sqe;
+}
+
+void	UringBackend::publishSqes(){
+	__atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+}
+
+int	UringBackend::enter(unsigned min_complete, unsigned flags, void* arg, size_t arg_size){
+	unsigned	to_submit = sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+	return syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, arg, arg_size);
+}
+
+void	UringBackend::armAccept(){
+	struct io_uring_sqe*	sqe = getSqe();
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = listen_fd_;
+	sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+	sqe->user_data = OP_ACCEPT;
+}
+
+void	UringBackend::armRecv(int fd){
+	fdState(fd).recv_armed = true;
+	struct io_uring_sqe*	sqe = getSqe();
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = fd;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = BUFFER_GROUP;
+	sqe->user_data = encode(OP_RECV, fd, fdState(fd).generation);
+}
+
+/**
+ * @brief The multishot recv ended, start a new one unless reading is paused.
+ */
+void	UringBackend::rearmRecv(int fd){
+	FdState&	state = fdState(fd);
+	state.recv_armed = false;
+	if (!state.read_paused){
+		armRecv(fd);
+	}
+}
+
+void	UringBackend::armWakeUp(){
+	struct io_uring_sqe*	sqe = getSqe();
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = wake_fd_;
+	sqe->poll32_events = POLLIN;
+	sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->user_data = OP_WAKEUP;
+}
+
+void	UringBackend::submitSend(SendOp* op){
+	op->msg = {};
+	op->msg.msg_iov = op->iov + op->first_iov;
+	op->msg.msg_iovlen = op->n_iov - op->first_iov;
+
+	struct io_uring_sqe*	sqe = getSqe();
+	sqe->opcode = IORING_OP_SENDMSG;
+	sqe->fd = op->fd;
+	sqe->addr = reinterpret_cast<uint64_t>(&op->msg);
+	sqe->len = 1;
+	sqe->msg_flags = MSG_NOSIGNAL;
+	sqe->user_data = reinterpret_cast<uint64_t>(op) | OP_SEND;
+}
+
+/**
+ * @brief Give a receive buffer back to the kernel. The new tail is published
+ * once per batch in wait().
+ */
+void	UringBackend::recycleBuffer(uint16_t buffer_id){
+	// not buf_ring_->bufs: compiled as C++ the header's flex array wrapper puts
+	// it at offset 8, the ring entries start right at the beginning
+	struct io_uring_buf*	buf = reinterpret_cast<struct io_uring_buf*>(buf_ring_)
+		+ (buf_local_tail_ & (URING_RECV_BUFFERS - 1));
+	buf->addr = reinterpret_cast<uint64_t>(buffers_ + buffer_id * URING_RECV_BUFFER_SIZE);
+	buf->len = URING_RECV_BUFFER_SIZE;
+	buf->bid = buffer_id;
+	buf_local_tail_++;
+}
+
+UringBackend::FdState&	UringBackend::fdState(int fd){
+	if (static_cast<size_t>(fd) >= fds_.size()){
+		fds_.resize(fd + 1, FdState{0, false, false, false});
+	}
+	return fds_[fd];
+}
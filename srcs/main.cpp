@@ -14,15 +14,21 @@
 #include "Server.hpp"
 
 int main(int ac, char** av){
-    if (ac != 3){
-        std::cerr << "Usage: ./ircserv <port> <password>\n";
+    if (ac < 3){
+        std::cerr << ServerConfig::usage();
         return EXIT_FAILURE;
     }
     try{
-        Server serv(av[1], av[2]);
-        serv.startServer();
+        ServerConfig config = ServerConfig::fromArgs(ac - 3, av + 3);
+        Logger::start(config.log_overflow);
+        {
+            Server serv(av[1], av[2], config);
+            serv.startServer();
+        }
+        Logger::stop();
         return EXIT_SUCCESS;
     }catch(const std::exception& e){
+        Logger::stop();
         std::cerr << RED << e.what() << RESET << std::endl;
         return EXIT_FAILURE;
     }